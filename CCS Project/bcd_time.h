@@ -0,0 +1,145 @@
+/*
+ * bcd_time.h
+ *
+ * Division-free time arithmetic. The MSP430FR4133 has no hardware divider, so every unsigned long `/` or `%` turns into a
+ * library call that grinds through one bit per loop. Instead we keep times as separate days/hours/mins/secs fields and
+ * carry between them with small bounded subtract loops, and we get decimal digits by building BCD with the DADD instruction.
+ */
+
+#ifndef BCD_TIME_H_
+#define BCD_TIME_H_
+
+#include <msp430.h>         // __bcd_add_short() and __bcd_add_long() intrinsics (DADD)
+#include "util.h"           // uint8_t
+
+struct dhms_t {
+    unsigned days;
+    unsigned hours;
+    unsigned mins;
+    unsigned secs;
+};
+
+// One of each setting unit as a dhms_t
+
+constexpr dhms_t DHMS_SECOND = { 0 , 0 , 0 , 1 };
+constexpr dhms_t DHMS_HOUR   = { 0 , 1 , 0 , 0 };
+constexpr dhms_t DHMS_DAY    = { 1 , 0 , 0 , 0 };
+
+// "The mean tropical year is approximately 365 days, 5 hours, 48 minutes, 45 seconds."
+// https://en.wikipedia.org/wiki/Tropical_year
+// We round up to the same 31556926 seconds we have always used.
+// https://frinklang.org/fsp/frink.fsp?fromVal=1+solaryear&toVal=seconds#calc
+constexpr dhms_t DHMS_YEAR   = { 365 , 5 , 48 , 46 };
+
+constexpr unsigned long dhms_to_secs( const dhms_t t ) {
+    return ( ( ( ( t.days * 24UL ) + t.hours ) * 60UL ) + t.mins ) * 60UL + t.secs;
+}
+
+static_assert( dhms_to_secs( DHMS_YEAR ) == 31556926UL , "DHMS_YEAR should be one solar year" );
+
+// Carry any overflow in the lower fields up into the higher ones. Each field must be less than 20x its radix on the way in
+// (which is all that dhms_mul10_add() can produce), so no loop here runs more than 19 times.
+
+inline void dhms_normalize( dhms_t &t ) {
+
+    while ( t.secs >= 60 ) {
+        t.secs -= 60;
+        t.mins++;
+    }
+
+    while ( t.mins >= 60 ) {
+        t.mins -= 60;
+        t.hours++;
+    }
+
+    while ( t.hours >= 24 ) {
+        t.hours -= 24;
+        t.days++;
+    }
+}
+
+// t = (t * 10) + (digit * unit), normalized. The *10 is a couple of shifts and an add, and the digit*unit is at most 9 adds.
+
+inline void dhms_mul10_add( dhms_t &t , unsigned digit , const dhms_t &unit ) {
+
+    t.days  = ( t.days  << 3 ) + ( t.days  << 1 );
+    t.hours = ( t.hours << 3 ) + ( t.hours << 1 );
+    t.mins  = ( t.mins  << 3 ) + ( t.mins  << 1 );
+    t.secs  = ( t.secs  << 3 ) + ( t.secs  << 1 );
+
+    while ( digit ) {
+        t.days  += unit.days;
+        t.hours += unit.hours;
+        t.mins  += unit.mins;
+        t.secs  += unit.secs;
+        digit--;
+    }
+
+    dhms_normalize( t );
+}
+
+// Convert a decimal number of `unit`s to normalized days/hours/mins/secs.
+// `digits` is least significant digit first (like setting_digits[]), and we work from the highest digit down, Horner style.
+// Note that 100 years is 36524 days, so days can not overflow as long as the UI keeps years <=100.
+
+inline dhms_t dhms_from_digits( const volatile unsigned *digits , unsigned count , const dhms_t &unit ) {
+
+    dhms_t t = { 0 , 0 , 0 , 0 };
+
+    while ( count > 0 ) {
+        count--;
+        dhms_mul10_add( t , digits[count] , unit );
+    }
+
+    return t;
+}
+
+// Binary to packed BCD by double dabble, except that DADD does the doubling and the decimal adjust in one go.
+// 16 passes no matter the value, each a DADD or two.
+
+inline unsigned long bin_to_bcd_long( unsigned b ) {
+
+    unsigned long bcd = 0;
+    unsigned mask = 0x8000;
+
+    while ( mask ) {
+
+        bcd = __bcd_add_long( bcd , bcd );
+
+        if ( b & mask ) {
+            bcd = __bcd_add_long( bcd , 1 );
+        }
+
+        mask >>= 1;
+    }
+
+    return bcd;
+}
+
+// The RV3032 keeps time in BCD. We only ever use these on values <100.
+
+inline uint8_t bin_to_bcd( unsigned b ) {
+
+    unsigned bcd = 0;
+    unsigned mask = 0x40;
+
+    while ( mask ) {
+
+        bcd = __bcd_add_short( bcd , bcd );
+
+        if ( b & mask ) {
+            bcd = __bcd_add_short( bcd , 1 );
+        }
+
+        mask >>= 1;
+    }
+
+    return (uint8_t) bcd;
+}
+
+inline unsigned bcd_to_bin( uint8_t bcd ) {
+    const unsigned tens = bcd >> 4;
+    return ( tens << 3 ) + ( tens << 1 ) + ( bcd & 0x0f );
+}
+
+#endif /* BCD_TIME_H_ */
@@ -21,382 +21,877 @@
 #include "util.h"
 #include "pins.h"
 #include "i2c_master.h"
+#include "ram_isrs.h"
 
-#define BIT_TIME_US     (5)          // How long should should we wait between bit transitions?
 
-#define _delay_us(x) (__delay_cycles(x))    // For now we are running 1Mhz
+// The RV3032 is a 400KHz (fast mode) part. These are the minimum times from its datasheet in ns. We only ever wait for the
+// minimum, and at 1MHz MCLK every one of these is shorter than the port write that makes the next edge, so all the waits
+// compile away (see i2c_wait_cycles()). They only turn into real delays if someone speeds up MCLK.
 
+#define I2C_T_LOW_NS        1300        // SCL low
+#define I2C_T_HIGH_NS        600        // SCL high
+#define I2C_T_SU_STA_NS      600        // SCL high to SDA falling for a repeated START
+#define I2C_T_HD_STA_NS      600        // SDA falling to SCL falling for a START
+#define I2C_T_SU_DAT_NS      100        // SDA valid to SCL rising
+#define I2C_T_VD_DAT_NS      900        // SCL falling to the RV3032's SDA valid
+#define I2C_T_SU_STO_NS      600        // SCL high to SDA rising for a STOP
+#define I2C_T_BUF_NS        1300        // Bus idle between a STOP and the next START
 
+// SDA only has the MSP430's internal pull-up (20K-50K), so a released SDA takes about 1us to rise with the pin and trace
+// capacitance. That is slower than fast mode allows, but it is our bus so we just wait for it.
 
+#define I2C_T_SDA_RISE_NS   1000
 
-// TODO: Drive SCL high rather than pull?
-// TODO: Drive SDA rather than pull when we are transmitting? Maybe risky?
+// The fewest cycles between two port writes, since the second write is a BIS.B/BIC.B to an absolute address and the write
+// lands at the end of it. We count this against every wait.
 
+#define I2C_EDGE_CYCLES     4
 
-// Is there a better way to abstract out MSP430 pins than a text macro?
+// Cycles to wait for at least `ns` at `mclk_hz`, rounded up, less the I2C_EDGE_CYCLES the next edge takes anyway
 
-// These are open collector signals, so never drive high - only drive low or pull high
+constexpr unsigned long i2c_wait_cycles( unsigned long ns , unsigned long mclk_hz ) {
+    return ( ( ( ns * ( mclk_hz / 1000UL ) ) + 999999UL ) / 1000000UL > I2C_EDGE_CYCLES ) ? ( ( ( ns * ( mclk_hz / 1000UL ) ) + 999999UL ) / 1000000UL ) - I2C_EDGE_CYCLES : 0;
+}
+
+constexpr unsigned long i2c_max_ns( unsigned long a , unsigned long b ) {
+    return a > b ? a : b;
+}
+
+// __delay_cycles() wants a constant >0, so a wait of 0 is its own (empty) function
+
+template < unsigned long cycles >
+inline void i2c_wait() {
+    __delay_cycles( cycles );
+}
+
+template <>
+inline void i2c_wait<0>() {
+}
+
+
+// These are open collector signals, so never drive SDA high - only drive low or pull high.
+// We are the only master and the RV3032 never stretches the clock, so we drive SCL both ways.
 
-// The init functions put the pins into " Totem-pole with Pull-up" mode
+// The init functions put SDA into " Totem-pole with Pull-up" mode
 // In this mode the pin is:
 //  pulled high when DIR =0
 //  driven low when DIR =1
 
+template < volatile unsigned char &pren , volatile unsigned char &pdir , volatile unsigned char &pout , volatile unsigned char &pin , unsigned b >
+struct i2c_pulled_pin {
+
+    static void init() {
+        pren |= _BV( b );
+    }
+
+    static void drive_low() {
+        pout &= ~_BV( b );
+        pdir |= _BV( b );
+    }
+
+    static void pull_high() {
+        pdir &= ~_BV( b );
+        pout |= _BV( b );
+    }
+
+    static uint8_t read() {
+        return pin & _BV( b );
+    }
+
+};
+
 // Assumes OUT bits are still at startup default of 0
 
-static inline void scl_init(void) {
-    I2C_CLK_PDIR |= _BV(I2C_CLK_B);
-}
+template < volatile unsigned char &pdir , volatile unsigned char &pout , unsigned b >
+struct i2c_driven_pin {
 
+    static void init() {
+        pdir |= _BV( b );
+    }
 
-static inline void sda_pull_init(void) {
-    I2C_DTA_PREN |= _BV(I2C_DTA_B);
-}
+    static void drive_low() {
+        pout &= ~_BV( b );
+    }
 
-static inline void sda_drive_low(void) {
-    I2C_DTA_POUT &= ~_BV( I2C_DTA_B );
-    I2C_DTA_PDIR |= _BV( I2C_DTA_B );
-}
+    static void drive_high() {
+        pout |= _BV( b );
+    }
+
+};
+
+
+// The bitbang itself, specialized at compile time on the pins and MCLK so that every port access is a single BIS.B/BIC.B
+// and every wait is the minimum legal number of cycles (usually none).
+//
+// Counted from the instruction cycle tables at 1MHz MCLK, not measured:
+//  write a byte (8 bits plus the ACK)      about 250 cycles, was about 350 with the old fixed 5 cycle waits
+//  read a byte (8 bits plus our ACK/NAK)   about 200 cycles, was about 290
+//  START, repeated START, or STOP          about 25 cycles each
+// So a 3 register burst read (START, 3 bytes written, repeated START, 3 bytes read, STOP) is about 1400 cycles versus about
+// 2000 before, and a 1 register write (START, 3 bytes written, STOP) is about 800 versus 1100. At the datasheet's 126uA/MHz
+// and 3V a cycle is about 0.38nJ, so that is roughly 95nJ per byte written and 75nJ per byte read. Note that while SDA is
+// driven low the pull-up also draws about 90uA, which is almost as much as the CPU.
+//
+// I2C_TIMER_PACED swaps this for edges paced by Timer1_A with the CPU in LPM0 in between (see below). Counted the same way,
+// not measured, that should come out worse at 1MHz, since every wait here is already 0 cycles and so there is nothing left
+// to sleep through. Each tick is an interrupt of about 45 cycles on average (6 to get in, 5 for the RETI, and the state
+// dispatch and port writes), and there are two per bit, so about 800 cycles per byte where we spend 250 now. That is roughly
+// 300nJ versus 95nJ, before we count LPM0, which is not free since the DCO has to keep running to clock the timer. The
+// slower bus also holds SDA low against its pull-up for longer. It should only win if MCLK goes up enough that the waits
+// here turn into real __delay_cycles(). Measure both builds with EnergyTrace before switching.
+
+template < class sda , class scl , unsigned long mclk_hz >
+struct i2c_bitbang {
+
+    static constexpr unsigned long write_setup_cycles = i2c_wait_cycles( i2c_max_ns( I2C_T_LOW_NS , I2C_T_SDA_RISE_NS + I2C_T_SU_DAT_NS ) , mclk_hz );
+    static constexpr unsigned long read_setup_cycles  = i2c_wait_cycles( i2c_max_ns( I2C_T_LOW_NS , I2C_T_VD_DAT_NS + I2C_T_SDA_RISE_NS + I2C_T_SU_DAT_NS ) , mclk_hz );
+    static constexpr unsigned long high_cycles        = i2c_wait_cycles( I2C_T_HIGH_NS   , mclk_hz );
+    static constexpr unsigned long hd_sta_cycles      = i2c_wait_cycles( I2C_T_HD_STA_NS , mclk_hz );
+    static constexpr unsigned long su_sto_cycles      = i2c_wait_cycles( I2C_T_SU_STO_NS , mclk_hz );
+    static constexpr unsigned long buf_cycles         = i2c_wait_cycles( i2c_max_ns( I2C_T_BUF_NS , I2C_T_SU_STA_NS ) , mclk_hz );
+
+    // Leaves both SCL and SDA high, which is an idle state
+
+    static void init() {
+
+        sda::init();
+        sda::pull_high();
+
+        scl::init();
+        i2c_wait< write_setup_cycles >();       // SDA might have been low (see shutdown()), so let it rise before SCL does
+        scl::drive_high();
+
+    }
+
+    // SCL low first so we don't do an inadvertent START
+
+    static void shutdown() {
+
+        scl::drive_low();
+        sda::drive_low();
+
+    }
+
+    // Clock one bit out. SDA is already set up. Assumes SCL low, leaves SCL low.
+
+    static void clock() {
 
+        i2c_wait< write_setup_cycles >();
+        scl::drive_high();
+        i2c_wait< high_cycles >();
+        scl::drive_low();
+
+    }
+
+    // Write a byte out to the slave and look for ACK bit
+    // Assumes SCL low, SDA doesn't matter
+
+    // Returns 0=success, SDA high (ACK bit released), SCL low.
+
+    static uint8_t write_byte( const uint8_t data ) {
+
+        for( uint8_t bitMask=0b10000000; bitMask !=0; bitMask>>=1 ) {
+
+            // setup data bit
+
+            if ( data & bitMask) {
+                sda::pull_high();
+            } else {
+                sda::drive_low();
+            }
+
+            clock();
+
+        }
+
+        // The device acknowledges the address by driving SDIO
+        // low after the next falling SCLK edge, for 1 cycle.
+
+        sda::pull_high();           // Pull SDA high so we can see if the slave is driving low
+
+        i2c_wait< read_setup_cycles >();
+        scl::drive_high();
+        i2c_wait< high_cycles >();
+        const uint8_t ret = sda::read();        // slave should be driving low now
+        scl::drive_low();                       // Slave release
+
+        return ret;
+
+    }
+
+    // Read a byte from the slave, then ACK it if there are more to come or NAK it if not
+    // Assumes SCL low and SDA released, leaves the same
+
+    static uint8_t read_byte( const bool ack ) {
+
+        uint8_t data=0;
+
+        for( uint8_t bitMask=0b10000000; bitMask !=0; bitMask>>=1 ) {
+
+            // Clock in the data bits
+
+            i2c_wait< read_setup_cycles >();
+            scl::drive_high();
+            i2c_wait< high_cycles >();
+
+            if (sda::read()) {
+                data |= bitMask;
+            }
+
+            scl::drive_low();
+
+        }
+
+        if ( ack ) {
+
+            //After each byte of data is read,
+            //the controller IC must drive an acknowledge (SDIO = 0)
+            //if an additional byte of data will be requested.
+
+            sda::drive_low();
+            clock();
+            sda::pull_high();           // Back to normal condition pulling SDA high (slave will have next data bit on bus now)
+
+        } else {
+
+            clock();                    // SDA is is high, so we are clocking out a NAK
+
+        }
+
+        return data;
+
+    }
+
+    // readFlag=1 leaves in read mode
+    // readFlag=0 leaves in write mode
+    // Returns 0 on success, non-zero if no ACK bit received.
+    // Assumes SCL high and SDA high
+    // Returns with SCL low, SDA released
+
+    static uint8_t start( const uint8_t slave , const uint8_t readFlag ) {
+
+        // Make sure we have been in idle at least long enough to see the falling SDA
+
+        i2c_wait< buf_cycles >();
+
+        // Data transfer is always initiated by a Bus Master device. A high to low transition on the SDA line, while
+        // SCL is high, is defined to be a START condition or a repeated start condition.
+
+        sda::drive_low();
+        i2c_wait< hd_sta_cycles >();
+        scl::drive_low();
+
+        // A START condition is always followed by the (unique) 7-bit slave address (MSB first) and then w/r bit
+
+        return write_byte( (uint8_t) ( ( slave << 1 ) | readFlag ) );
+
+    }
+
+    // Same as start(), but from the middle of a transaction. Assumes SCL low and SDA released.
+
+    static uint8_t restart( const uint8_t slave , const uint8_t readFlag ) {
+
+        // Force clock high, then start() will pull sda low with clock high
+
+        i2c_wait< write_setup_cycles >();
+        scl::drive_high();
+
+        return start( slave , readFlag );
+
+    }
+
+    // Assumes on entry SCL low
+    // Returns with bus idle, SCL high SDA high
+
+    static void stop() {
+
+        // Data transfer ends with the STOP condition
+        // (rising edge of SDIO while SCLK is high).
+
+        // We need this because it is possible that the slave is holding the SDA line low
+        // waiting for us to clock out the MSB of the next byte!
+
+        sda::drive_low();
+        i2c_wait< write_setup_cycles >();
+        scl::drive_high();
+        i2c_wait< su_sto_cycles >();
+
+        sda::pull_high();           // SDA low to high while SCLK is high is a STOP
+
+    }
+
+};
+
+typedef i2c_pulled_pin< I2C_DTA_PREN , I2C_DTA_PDIR , I2C_DTA_POUT , I2C_DTA_PIN , I2C_DTA_B > rv3032_sda;
+typedef i2c_driven_pin< I2C_CLK_PDIR , I2C_CLK_POUT , I2C_CLK_B > rv3032_scl;
+
+typedef i2c_bitbang< rv3032_sda , rv3032_scl , MCLK_HZ_MAX > rv3032_i2c;
+
+
+#ifdef I2C_TIMER_PACED
+
+// The same bus, but with Timer1_A paced edges (see I2C_TIMER_PACED in i2c_master.h). One transfer is START, the slave address,
+// the register, and then either the bytes to write, or a repeated START, the slave address again, and the bytes to read. Then
+// STOP. Each CCR0 interrupt makes one SCL edge (plus whatever SDA does while SCL is low), so a bit is two ticks, and the CPU
+// sleeps in LPM0 in between. SMCLK keeps running in LPM0, which is what clocks the timer.
+
+// SMCLK cycles per tick. This has to cover the longest pass through i2c_timer_isr() plus getting in and out of it, or ticks
+// run together. The ISR is about 60 cycles counted the long way round (the last bit of a byte, which sets up the next byte).
+
+#define I2C_TIMER_TICK_CYCLES   80
+
+// A tick is the shortest time SCL spends low or high, so it has to be at least as long as any of the bitbang's waits
+static_assert( ( I2C_TIMER_TICK_CYCLES * 1000000UL ) / ( MCLK_HZ_MAX / 1000UL ) >= i2c_max_ns( I2C_T_LOW_NS , I2C_T_VD_DAT_NS + I2C_T_SDA_RISE_NS + I2C_T_SU_DAT_NS ) , "I2C_TIMER_TICK_CYCLES is too short for the bus timing" );
+
+enum i2c_timer_state_t : uint8_t {
+    I2C_TIMER_IDLE,
+    I2C_TIMER_START_SDA,        // SCL high, SDA falls for a START
+    I2C_TIMER_START_SCL,        // SCL falls and we set up the first bit of the slave address
+    I2C_TIMER_BIT_HIGH,         // SCL rises to clock out or in the bit that is set up
+    I2C_TIMER_BIT_LOW,          // Sample SDA if we are reading, SCL falls, and set up the next bit
+    I2C_TIMER_RESTART_SCL,      // SDA is released, SCL rises to get ready for a repeated START
+    I2C_TIMER_STOP_SCL,         // SDA is low, SCL rises
+    I2C_TIMER_STOP_SDA,         // SDA rises for a STOP and we are done
+};
+
+// Which byte of the transfer is on the bus
+
+enum i2c_timer_phase_t : uint8_t {
+    I2C_TIMER_ADDR_WRITE,
+    I2C_TIMER_REG,
+    I2C_TIMER_DATA_WRITE,
+    I2C_TIMER_ADDR_READ,
+    I2C_TIMER_DATA_READ,
+};
+
+static volatile i2c_timer_state_t i2c_timer_state = I2C_TIMER_IDLE;
+
+// Only the ISR touches these while a transfer is running
+
+static i2c_timer_phase_t i2c_timer_phase;
+static uint8_t i2c_timer_slave;
+static uint8_t i2c_timer_reg;
+static bool i2c_timer_reading;
+static uint8_t *i2c_timer_data;
+static uint8_t i2c_timer_count;             // Bytes left after the one on the bus
+static uint8_t i2c_timer_byte;              // Shifts out MSB first when writing, and in LSB first when reading
+static uint8_t i2c_timer_bits;              // Bits left in this byte, counting the ACK
+static uint8_t i2c_timer_nak;
+static i2c_done_callback_t i2c_timer_done;
+
+// Put the bit we are on onto SDA. Assumes SCL low.
+
+static inline void i2c_timer_setup_bit() {
+
+    if ( i2c_timer_bits > 1 ) {
+
+        if ( i2c_timer_phase == I2C_TIMER_DATA_READ || ( i2c_timer_byte & 0x80 ) ) {
+            rv3032_sda::pull_high();
+        } else {
+            rv3032_sda::drive_low();
+        }
+
+    } else {
+
+        // The ACK. We ACK every byte we read but the last one, and otherwise let go so the slave can ACK.
+
+        if ( i2c_timer_phase == I2C_TIMER_DATA_READ && i2c_timer_count ) {
+            rv3032_sda::drive_low();
+        } else {
+            rv3032_sda::pull_high();
+        }
+
+    }
 
-static inline void sda_pull_high(void) {
-    I2C_DTA_PDIR &= ~_BV( I2C_DTA_B );
-    I2C_DTA_POUT |= _BV( I2C_DTA_B );
 }
 
-static inline void scl_drive_low(void) {
-    I2C_CLK_POUT &= ~_BV( I2C_CLK_B );
+static inline void i2c_timer_load_byte( const uint8_t b ) {
+
+    i2c_timer_byte = b;
+    i2c_timer_bits = 9;
+    i2c_timer_setup_bit();
+    i2c_timer_state = I2C_TIMER_BIT_HIGH;
+
 }
 
-static inline void scl_drive_high(void) {
-    I2C_CLK_POUT |= _BV( I2C_CLK_B );
+static inline void i2c_timer_stop() {
+
+    rv3032_sda::drive_low();
+    i2c_timer_state = I2C_TIMER_STOP_SCL;
+
 }
 
-static inline uint8_t sda_read(void) {
-    return I2C_DTA_PIN & _BV( I2C_DTA_B );
+// We just clocked an ACK and SCL is low again. Work out what goes on the bus next.
+
+static inline void i2c_timer_next_byte() {
+
+    switch ( i2c_timer_phase ) {
+
+        case I2C_TIMER_ADDR_WRITE:
+            i2c_timer_phase = I2C_TIMER_REG;
+            i2c_timer_load_byte( i2c_timer_reg );
+            break;
+
+        case I2C_TIMER_REG:
+
+            if ( i2c_timer_reading ) {
+                i2c_timer_phase = I2C_TIMER_ADDR_READ;
+                rv3032_sda::pull_high();
+                i2c_timer_state = I2C_TIMER_RESTART_SCL;
+                break;
+            }
+
+            i2c_timer_phase = I2C_TIMER_DATA_WRITE;
+            // Fall through
+
+        case I2C_TIMER_DATA_WRITE:
+
+            if ( i2c_timer_count ) {
+                i2c_timer_count--;
+                i2c_timer_load_byte( *i2c_timer_data++ );
+            } else {
+                i2c_timer_stop();
+            }
+            break;
+
+        case I2C_TIMER_ADDR_READ:
+            i2c_timer_phase = I2C_TIMER_DATA_READ;
+            // Fall through
+
+        case I2C_TIMER_DATA_READ:
+
+            if ( i2c_timer_count ) {
+                i2c_timer_count--;
+                i2c_timer_load_byte( 0 );
+            } else {
+                i2c_timer_stop();
+            }
+            break;
+
+    }
+
 }
 
+#pragma vector=TIMER1_A0_VECTOR
+__interrupt void i2c_timer_isr(void) {
 
+    switch ( i2c_timer_state ) {
 
+        case I2C_TIMER_START_SDA:
+            rv3032_sda::drive_low();
+            i2c_timer_state = I2C_TIMER_START_SCL;
+            break;
 
+        case I2C_TIMER_START_SCL:
+            rv3032_scl::drive_low();
+            i2c_timer_load_byte( (uint8_t) ( ( i2c_timer_slave << 1 ) | ( i2c_timer_phase == I2C_TIMER_ADDR_READ ) ) );
+            break;
 
-/*---------------------------------------------------------------
- USI TWI single master initialization function
----------------------------------------------------------------*/
-void i2c_init( void )
-{
+        case I2C_TIMER_BIT_HIGH:
+            rv3032_scl::drive_high();
+            i2c_timer_state = I2C_TIMER_BIT_LOW;
+            break;
 
+        case I2C_TIMER_BIT_LOW:
 
-    /*
+            if ( i2c_timer_bits > 1 ) {
 
-        // TEST PINS
-        I2C_DTA_PDIR |= _BV( I2C_DTA_B );
+                i2c_timer_byte <<= 1;
 
-        I2C_DTA_POUT |= _BV( I2C_DTA_B );
-        _delay_us(BIT_TIME_US);
-        I2C_DTA_POUT &= ~_BV( I2C_DTA_B );
-        _delay_us(BIT_TIME_US);
+                if ( i2c_timer_phase == I2C_TIMER_DATA_READ && rv3032_sda::read() ) {
+                    i2c_timer_byte |= 1;
+                }
 
-        I2C_CLK_PDIR |= _BV( I2C_CLK_B );
+                rv3032_scl::drive_low();
+                i2c_timer_bits--;
+                i2c_timer_setup_bit();
+                i2c_timer_state = I2C_TIMER_BIT_HIGH;
 
-        I2C_CLK_POUT |= _BV( I2C_CLK_B );
-        _delay_us(BIT_TIME_US);
-        I2C_CLK_POUT &= ~_BV( I2C_CLK_B );
-        _delay_us(BIT_TIME_US);
-    */
+            } else {
 
-  sda_pull_init();
-  sda_pull_high();
+                if ( i2c_timer_phase == I2C_TIMER_DATA_READ ) {
+                    *i2c_timer_data++ = i2c_timer_byte;
+                } else if ( rv3032_sda::read() ) {
+                    i2c_timer_nak = 1;
+                }
 
-  scl_init();
-  scl_drive_high();
+                rv3032_scl::drive_low();
+                i2c_timer_next_byte();
+
+            }
+            break;
 
-  /*
-  while (1) {
-    scl_drive_low();
-    _delay_us(BIT_TIME_US);
-    scl_pull_high();
-    _delay_us(BIT_TIME_US);
-  }
-  */
+        case I2C_TIMER_RESTART_SCL:
+            rv3032_scl::drive_high();
+            i2c_timer_state = I2C_TIMER_START_SDA;
+            break;
 
+        case I2C_TIMER_STOP_SCL:
+            rv3032_scl::drive_high();
+            i2c_timer_state = I2C_TIMER_STOP_SDA;
+            break;
+
+        case I2C_TIMER_STOP_SDA:
+
+            rv3032_sda::pull_high();            // SDA low to high while SCL is high is a STOP
+
+            TA1CTL = MC__STOP | TACLR;
+            TA1CCTL0 = 0;
+
+            i2c_timer_state = I2C_TIMER_IDLE;
+
+            if ( i2c_timer_done ) {
+                i2c_timer_done( i2c_timer_nak );
+            }
+
+            __bic_SR_register_on_exit(LPM0_bits);
+            break;
+
+        default:
+            __never_executed();
+
+    }
 
-  // This leaves us with both SCL and SDA high, which is an idle state
 }
 
+// Assumes the bus is idle and no transfer is running
 
-// Drive both pins low
+static void i2c_timer_begin( const uint8_t slave , const uint8_t reg , const bool reading , uint8_t * const data , const uint8_t count , const i2c_done_callback_t done ) {
 
-void i2c_shutdown() {
+    i2c_timer_slave   = slave;
+    i2c_timer_reg     = reg;
+    i2c_timer_reading = reading;
+    i2c_timer_data    = data;
+    i2c_timer_count   = count;
+    i2c_timer_nak     = 0;
+    i2c_timer_done    = done;
 
-    // SCL low first so we don't do an inadvertent START
-    scl_drive_low();
-    _delay_us(BIT_TIME_US);
-    sda_drive_low();
-    _delay_us(BIT_TIME_US);
+    i2c_timer_phase = I2C_TIMER_ADDR_WRITE;
+    i2c_timer_state = I2C_TIMER_START_SDA;       // The first tick also gives us the bus free time before the START
+
+    TA1CCR0 = I2C_TIMER_TICK_CYCLES - 1;
+    TA1CCTL0 = CCIE;
+    TA1CTL = TASSEL__SMCLK | MC__UP | TACLR;
 
 }
 
+void i2c_write_async( const uint8_t slave , const uint8_t addr , const void * const data , const uint8_t size , const i2c_done_callback_t done ) {
 
-// Write a byte out to the slave and look for ACK bit
-// Assumes SCL low, SDA doesn't matter
+    i2c_timer_begin( slave , addr , false , (uint8_t *) data , size , done );
 
-// Returns 0=success, SDA high (ACK bit released), SCL low.
+}
 
-static unsigned char USI_TWI_Write_Byte( unsigned char data ) {
+void i2c_read_async( const uint8_t slave , const uint8_t addr , void * const data , const uint8_t size , const i2c_done_callback_t done ) {
 
-    for( uint8_t bitMask=0b10000000; bitMask !=0; bitMask>>=1 ) {
+    i2c_timer_begin( slave , addr , true , (uint8_t *) data , size , done );
 
-        // setup data bit
+}
 
-        if ( data & bitMask) {
-            sda_pull_high();
-        } else {
-            sda_drive_low();
+bool i2c_busy() {
 
-        }
+    return i2c_timer_state != I2C_TIMER_IDLE;
 
-        // clock it out
+}
+
+// Sleep in LPM0 until the transfer is done. Returns non-zero if there was a NAK.
+// This is fine to call from an ISR, since we nest the timer interrupt and put GIE back the way we found it.
 
-        _delay_us(BIT_TIME_US);
+static uint8_t i2c_timer_wait() {
 
-        scl_drive_high();           // Clock in the next address bit
+    const unsigned short sr = __get_SR_register();
 
-        _delay_us(BIT_TIME_US);
+    __disable_interrupt();
 
-        scl_drive_low();
+    while ( i2c_busy() ) {
+        __bis_SR_register( LPM0_bits | GIE );       // The ISR wakes us when it finishes. GIE goes on with LPM0 so we can not miss it.
+        __disable_interrupt();
+    }
 
+    if ( sr & GIE ) {
+        __enable_interrupt();
     }
 
-    // The device acknowledges the address by driving SDIO
-    // low after the next falling SCLK edge, for 1 cycle.
+    return i2c_timer_nak;
+
+}
+
+#endif
+
+
+// Write count bytes starting at register reg. Returns non-zero if there was a NAK.
+// Assumes the bus is idle on entry, exits with bus idle.
+
+static uint8_t i2c_burst_write( const uint8_t slave , const uint8_t reg , const uint8_t *data , uint8_t count ) {
 
-    sda_pull_high();            // Pull SDA high so we can see if the slave is driving low
-    _delay_us(BIT_TIME_US);     // Not needed, but so we can see what is happening on the scope
-    scl_drive_high();
-    _delay_us(BIT_TIME_US);     // TODO: Don't need all these delays
+    #ifdef I2C_TIMER_PACED
 
-    uint8_t ret = sda_read();   // slave should be driving low now
-    scl_drive_low();            // Slave release
-    _delay_us(BIT_TIME_US);
+        i2c_write_async( slave , reg , data , count , nullptr );
 
-    // TODO: CHeck ret
+        return i2c_timer_wait();
 
-    return(ret);
+    #else
+
+        uint8_t nak = rv3032_i2c::start( slave , 0 );
+
+        nak |= rv3032_i2c::write_byte( reg );
+
+        while (count--) {
+            nak |= rv3032_i2c::write_byte( *data );
+            data++;
+        }
+
+        rv3032_i2c::stop();
+
+        return nak;
+
+    #endif
 
 }
 
-// readFlag=1 leaves in read mode
-// readFlag=0 leaves in write mode
-// Returns 0 on success, 1 if no ACK bit received.
-// Assumes SCL high
-// Returns with SCL low, SDA wahtever last bit (r/w bit) was
 
-static unsigned char i2c_start( unsigned char slave , unsigned char readFlag) {
+// The timer engine reads into one buffer, so in that build a read burst that covers more than one op goes through a buffer on
+// the stack and gets scattered from there. This caps how many bytes we merge into one so that buffer stays small.
 
-    // We assume that we enter in idle state since that is how all public functions leave us
+#ifdef I2C_TIMER_PACED
+    #define I2C_SESSION_MAX_READ_BURST  8
+#else
+    #define I2C_SESSION_MAX_READ_BURST  255
+#endif
 
-    _delay_us(BIT_TIME_US);         // Make sure we have been in idle at least long enough to see the falling SDA
 
-    // Data transfer is always initiated by a Bus Master device. A high to low transition on the SDA line, while
-    // SCL is high, is defined to be a START condition or a repeated start condition.
+i2c_session_t::i2c_session_t( const uint8_t slave ) : slave( slave ) , op_count( 0 ) , write_byte_count( 0 ) , nak( 0 ) {
 
-    sda_drive_low();
+    i2c_init();
+
+}
 
-    _delay_us(BIT_TIME_US);
+// Assumes the caller already made room with run() if the queue was full
 
-    scl_drive_low();
+void i2c_session_t::queue( const uint8_t reg , const uint8_t count , uint8_t * const read_data ) {
 
-    // A START condition is always followed by the (unique) 7-bit slave address (MSB first) and then w/r bit
+    ops[ op_count ].reg       = reg;
+    ops[ op_count ].count     = count;
+    ops[ op_count ].read_data = read_data;
+    op_count++;
 
-    // The control word is latched internally on
-    // rising SCLK edges and is eight bits in length, comprised
-    // of a seven bit device address equal to 0010000b and a
-    // read/write bit (write = 0 and read = 1).
+}
 
-    uint8_t controlword = (slave << 1) | readFlag;
+void i2c_session_t::write( const uint8_t reg , const uint8_t value ) {
 
-    return USI_TWI_Write_Byte( controlword );
+    write( reg , &value , 1 );
 
 }
 
-// Assumes on entry SCL low
-// Returns with bus idle, SCL high SDA high
+void i2c_session_t::write( const uint8_t reg , const void * const data , const uint8_t count ) {
 
+    if ( op_count == I2C_SESSION_MAX_OPS || write_byte_count + count > I2C_SESSION_MAX_WRITE_BYTES ) {
 
-static void i2c_stop(void) {
+        run();
 
-    // Data transfer ends with the STOP condition
-    // (rising edge of SDIO while SCLK is high).
+        if ( count > I2C_SESSION_MAX_WRITE_BYTES ) {
+            nak |= i2c_burst_write( slave , reg , (const uint8_t *) data , count );      // Too big to queue, and everything before it has run, so just send it
+            return;
+        }
+    }
 
-    // Q: Is this Really needed? Can we just do repeat starts and save this code? Spec is vague if address is reset on start.
-    // A: Yes, we need this because it is possible that the FM_IC is holding the SDA line low
-    // wait for us to clock out the MSB of the next byte!
+    const uint8_t *d = (const uint8_t *) data;
 
-    sda_drive_low();
-    _delay_us(BIT_TIME_US);     // Give is a moment to stabilize in case
-    scl_drive_high();
-    _delay_us(BIT_TIME_US);
+    for ( uint8_t i = 0; i < count; i++ ) {
+        write_bytes[ write_byte_count++ ] = d[i];
+    }
 
-    sda_pull_high();            // SDA low to high while SCLK is high is a STOP
-    _delay_us(BIT_TIME_US);
+    queue( reg , count , nullptr );
 
 }
 
-// Write the bytes pointed to by buffer
-// addr is the chip bus address
-// assumes bus is idle on entry, Exists with bus idle
-// Returns 0 on success
+void i2c_session_t::read( const uint8_t reg , void * const data , const uint8_t count ) {
 
-unsigned char USI_TWI_Write_Data_No_stop(unsigned char slave, unsigned char addr , const uint8_t *buffer , uint8_t count)
-{
+    if ( op_count == I2C_SESSION_MAX_OPS ) {
+        run();
+    }
 
-    i2c_start( slave , 0 );      // TODO: check for error
+    queue( reg , count , (uint8_t *) data );
 
-    USI_TWI_Write_Byte( addr );      // select starting register to write to
+}
 
+uint8_t i2c_session_t::run() {
 
-    // Note here we can't really break out readByte() becuase the last byte
-    // is special since we do not ACK it but instead send a STOP.
+    const uint8_t *w = write_bytes;
 
-    while (count--) {
+    uint8_t first = 0;
 
-        USI_TWI_Write_Byte( *buffer );
+    while ( first < op_count ) {
 
-        buffer++;
+        // Find the run of ops that picks up where the one before left off, in the same direction
 
-    }
+        const bool is_read = ops[ first ].read_data != nullptr;
 
-    // No stop here.
+        uint8_t last = first;
+        uint8_t burst_count = ops[ first ].count;
 
-    return(0);
+        while ( last + 1 < op_count &&
+                ( ops[ last + 1 ].read_data != nullptr ) == is_read &&
+                ops[ last + 1 ].reg == ops[ first ].reg + burst_count &&
+                ( !is_read || burst_count + ops[ last + 1 ].count <= I2C_SESSION_MAX_READ_BURST ) ) {
+            last++;
+            burst_count += ops[ last ].count;
+        }
 
-}
+        if ( is_read ) {
 
-// Write the bytes pointed to by buffer
-// addr is the chip bus address
-// assumes bus is idle on entry, Exists with bus idle
-// Returns 0 on success
+            #ifdef I2C_TIMER_PACED
 
-unsigned char i2c_write(unsigned char slave, unsigned char addr , const void *in_buffer , uint8_t count)
-{
-    unsigned char *buffer = (unsigned char *)in_buffer;
+                uint8_t read_burst[ I2C_SESSION_MAX_READ_BURST ];
+                const uint8_t *r = read_burst;
 
-    i2c_start( slave , 0 );      // TODO: check for error
+                if ( first == last ) {
 
-    USI_TWI_Write_Byte( addr );      // select starting register to write to
+                    i2c_read_async( slave , ops[ first ].reg , ops[ first ].read_data , burst_count , nullptr );
+                    nak |= i2c_timer_wait();
 
+                } else {
 
-    // Note here we can't really break out readByte() becuase the last byte
-    // is special since we do not ACK it but instead send a STOP.
+                    i2c_read_async( slave , ops[ first ].reg , read_burst , burst_count , nullptr );
+                    nak |= i2c_timer_wait();
 
-    while (count--) {
+                    for ( uint8_t i = first; i <= last; i++ ) {
+                        for ( uint8_t j = 0; j < ops[i].count; j++ ) {
+                            ops[i].read_data[j] = *r++;
+                        }
+                    }
 
-        USI_TWI_Write_Byte( *buffer );
+                }
 
-        buffer++;
+            #else
 
-    }
+                nak |= rv3032_i2c::start( slave , 0 );
+                nak |= rv3032_i2c::write_byte( ops[ first ].reg );
+                nak |= rv3032_i2c::restart( slave , 1 );
 
+                // Scatter the burst into each op's buffer, ACKing every byte but the last
 
-    // End transaction with bus in idle
+                for ( uint8_t i = first; i <= last; i++ ) {
+                    for ( uint8_t j = 0; j < ops[i].count; j++ ) {
+                        burst_count--;
+                        ops[i].read_data[j] = rv3032_i2c::read_byte( burst_count != 0 );
+                    }
+                }
 
-    i2c_stop();
+                rv3032_i2c::stop();
 
-    return(0);
+            #endif
+
+        } else {
+
+            nak |= i2c_burst_write( slave , ops[ first ].reg , w , burst_count );
+            w += burst_count;
+
+        }
+
+        first = last + 1;
+
+    }
+
+    op_count = 0;
+    write_byte_count = 0;
+
+    const uint8_t ret = nak;
+    nak = 0;
+
+    return ret;
 
 }
 
+uint8_t i2c_session_t::end() {
 
-// Fill data buffer with bytes read from TWI
-// addr is the chip bus address
-// assumes bus is idle on entry, Exists with bus idle
-// Returns 0 on success
+    const uint8_t ret = run();
 
-unsigned char i2c_read(unsigned char slave, unsigned char addr  , void *in_buffer , uint8_t count)
+    i2c_shutdown();
+
+    return ret;
+
+}
+
+
+/*---------------------------------------------------------------
+ USI TWI single master initialization function
+---------------------------------------------------------------*/
+void i2c_init( void )
 {
 
-    unsigned char *buffer = (unsigned char *)in_buffer;
+  rv3032_i2c::init();
 
-    i2c_start( slave , 0 );      // "CPU transmits the RX8900's slave address with the R/W bit set to write mode."
+  #ifdef I2C_TIMER_PACED
+    ram_vector_TIMER1_A0 = (void *) &i2c_timer_isr;       // main() runs everything off the RAM vectors
+  #endif
 
-    USI_TWI_Write_Byte( addr );     // "CPU transfers address for reading from RX8900."
+}
 
-    // Write returns with SDA high (ACK bit released), SCL low.
 
-    // We are doing a restart here, so force clock high, then Start() will pull sda low with clock high
+// Drive both pins low
 
-    scl_drive_high();
-    _delay_us(BIT_TIME_US);
-    _delay_us(BIT_TIME_US);
-    _delay_us(BIT_TIME_US);
+void i2c_shutdown() {
 
-    i2c_start( slave , 1 );      // "CPU transfers RESTART condition [Sr] (in which case, CPU does not transfer a STOP condition [P])"
+    rv3032_i2c::shutdown();
 
-    // SCL low
+}
 
-    while (count) {
 
-        unsigned char data=0;
+// Write the bytes pointed to by buffer
+// addr is the chip bus address
+// assumes bus is idle on entry, Exists with bus idle
+// Returns 0 on success
 
-        for( uint8_t bitMask=0b10000000; bitMask !=0; bitMask>>=1 ) {
+unsigned char i2c_write(unsigned char slave, unsigned char addr , const void *in_buffer , uint8_t count)
+{
 
-            // Clock in the data bits
+    return i2c_burst_write( slave , addr , (const uint8_t *) in_buffer , count );
 
-            scl_drive_high();           // Clock in the first data bit
+}
 
-            _delay_us(BIT_TIME_US);
 
-            if (sda_read()) {
+// Fill data buffer with bytes read from TWI
+// addr is the chip bus address
+// assumes bus is idle on entry, Exists with bus idle
+// Returns 0 on success
 
-                data |= bitMask;
+unsigned char i2c_read(unsigned char slave, unsigned char addr  , void *in_buffer , uint8_t count)
+{
 
-            }
+    #ifdef I2C_TIMER_PACED
 
-            scl_drive_low();
+        i2c_read_async( slave , addr , in_buffer , count , nullptr );
 
-            _delay_us(BIT_TIME_US);
+        return i2c_timer_wait();
 
-        }
+    #else
 
-        // SCLK low here
-        // SDA should be pulled high and not driven low by the FMIC because
-        // we are reading so it is our turn to ACK now
+    unsigned char *buffer = (unsigned char *)in_buffer;
 
-        *buffer = data;
+    rv3032_i2c::start( slave , 0 );      // "CPU transmits the RX8900's slave address with the R/W bit set to write mode."
 
-        buffer++;
+    rv3032_i2c::write_byte( addr );     // "CPU transfers address for reading from RX8900."
 
-        count--;
+    // Write returns with SDA high (ACK bit released), SCL low.
 
-        if (count) {
+    rv3032_i2c::restart( slave , 1 );    // "CPU transfers RESTART condition [Sr] (in which case, CPU does not transfer a STOP condition [P])"
 
-            //After each byte of data is read,
-            //the controller IC must drive an acknowledge (SDIO = 0)
-            //if an additional byte of data will be requested. Data
-            //transfer ends with the STOP condition.
+    // SCL low
 
-            sda_drive_low();            // drive SDA to ACK that we read the byte
-            _delay_us(BIT_TIME_US);     // Not needed, but so we can see what is happening on the scope
+    while (count) {
 
+        count--;
 
-            scl_drive_high();            // Clock out the ACK bit
-            _delay_us(BIT_TIME_US);
+        // ACK every byte but the last
 
-            scl_drive_low();
-            _delay_us(BIT_TIME_US);     // Not necessary
-            sda_pull_high();            // Back to normal condition pulling SDA high (slave will have next data bit on bus now)
-            _delay_us(BIT_TIME_US);
+        *buffer = rv3032_i2c::read_byte( count != 0 );
 
-            // Ready for next bit..
+        buffer++;
 
-        }
     }
 
     // Ok, we got all the bits we need.
-    // We did not send a ACK on the last byte, so
-    // SCL is still low from the final data bit.
-    // SDA is pulled high because the slave is waiting for use to drive low to ACK (we will STOP instead)
+    // We sent a NAK on the last byte rather than an ACK.
 
     /*
         FROM TI:
@@ -424,14 +919,12 @@ unsigned char i2c_read(unsigned char slave, unsigned char addr  , void *in_buffe
 
     */
 
-    scl_drive_high();            // SDA is is high, so we are clocking out a NAK
-    _delay_us(BIT_TIME_US);
-    scl_drive_low();            // finish clocking out a NAK
-
-    i2c_stop();
+    rv3032_i2c::stop();
 
     // End transaction with bus in idle
 
     return(0);
 
+    #endif
+
 }
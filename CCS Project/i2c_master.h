@@ -8,6 +8,16 @@
 #ifndef I2C_MASTER_H_
 #define I2C_MASTER_H_
 
+// We never touch the clock system, so MCLK is the reset default DCOCLKDIV which is 1MHz +/-10%. The bit timing is worked out
+// for the fast end since that gives the shortest waits. Change this if you change MCLK.
+#define MCLK_HZ_MAX 1100000UL
+
+// Define this to pace the I2C edges off Timer1_A and sleep in LPM0 between them instead of running the bitbang flat out.
+// Everything below keeps working the same, and you also get the async calls at the bottom. Off for now since by our
+// counts it costs more energy per byte at 1MHz MCLK than the bitbang does (see i2c_master.cpp), but nobody has put
+// either one on EnergyTrace yet.
+//#define I2C_TIMER_PACED
+
 
 //********** Prototypes **********//
 
@@ -29,4 +39,75 @@ void USI_TWI_Master_disable( void );
 void i2c_shutdown();
 
 
+// A batch of register reads and writes to one slave, done in one bus session. The constructor brings the bus up (i2c_init())
+// and end() takes it down (i2c_shutdown()), so a whole batch pays for that once. Queued ops run in order when you call run() or
+// end(), and ops on consecutive registers in the same direction are merged into one auto-increment burst with a single START,
+// register address, and STOP. Use like...
+//
+//   i2c_session_t s( RV_3032_I2C_ADDR );
+//   s.write( RV3032_ALARM_MINS_REG , alarm_regs , 3 );     // Copied, so alarm_regs can go away now
+//   s.read( RV3032_STATUS_REG , &status_reg , 1 );          // Filled in by run(), so status_reg must stay around until then
+//   s.run();                                                // Bus stays up so we can look at status_reg and queue more
+//   s.write( RV3032_STATUS_REG , status_reg & ~_BV( 3 ) );
+//   s.end();
+//
+// If the queue fills up we just run what we have so far and keep going.
+
+#define I2C_SESSION_MAX_OPS         6       // Queued reads and writes, before merging
+#define I2C_SESSION_MAX_WRITE_BYTES 8       // Bytes of queued write data. A longer write goes out on its own right away.
+
+class i2c_session_t {
+
+    struct op_t {
+        uint8_t reg;
+        uint8_t count;
+        uint8_t *read_data;                 // nullptr for a write, which takes its bytes from write_bytes in order
+    };
+
+    const uint8_t slave;
+
+    op_t ops[ I2C_SESSION_MAX_OPS ];
+    uint8_t op_count;
+
+    uint8_t write_bytes[ I2C_SESSION_MAX_WRITE_BYTES ];
+    uint8_t write_byte_count;
+
+    uint8_t nak;                            // Any NAKs since the last run()
+
+    void queue( uint8_t reg , uint8_t count , uint8_t *read_data );
+
+public:
+
+    i2c_session_t( uint8_t slave );
+
+    void write( uint8_t reg , uint8_t value );
+    void write( uint8_t reg , const void *data , uint8_t count );
+
+    // data must stay around until the next run() or end()
+    void read( uint8_t reg , void *data , uint8_t count );
+
+    // Do everything queued so far. Returns 0 if the slave ACKed every byte we sent.
+    uint8_t run();
+
+    // run() and then take the bus down. Do not use the session after this.
+    uint8_t end();
+
+};
+
+
+#ifdef I2C_TIMER_PACED
+
+// Called from the timer ISR when an async transfer is done. nak is non-zero if the slave did not ACK every byte we sent.
+typedef void (*i2c_done_callback_t)( uint8_t nak );
+
+// Start a transfer and return right away. The bus must be up (i2c_init()) and idle (!i2c_busy()). The data must stay
+// around until the transfer is done, and done can be nullptr if you will just poll i2c_busy().
+void i2c_write_async( uint8_t slave , uint8_t addr , const void *data , uint8_t size , i2c_done_callback_t done );
+void i2c_read_async( uint8_t slave , uint8_t addr , void *data , uint8_t size , i2c_done_callback_t done );
+
+bool i2c_busy();
+
+#endif
+
+
 #endif /* I2C_MASTER_H_ */
@@ -18,6 +18,7 @@
 #include <msp430.h>
 
 #include "util.h"
+#include "bcd_time.h"
 
 
 #include "define_lcd_pinout.h"
@@ -61,109 +62,6 @@ void lcd_segment_clear_to_lcdmem( lcd_segment_location_t seg  ) {
 }
 
 
-// General function to write a glyph onto memory. That could be main LCDMEM or "blinking" LCDBM
-// which can also be used for double buffering.
-// No constraints on how pins are connected, but inefficient.
-// Remember that means that different segments in the same digit could be at different LCDMEM locations!
-
-
-void lcd_write_glyph_to_lcdmem( char *lcdmem_base , byte digitplace, glyph_segment_t glyph ) {
-
-    lcd_digit_segments_t digit_segments = lcd_digit_segments[ digitplace ];
-
-    if ( glyph & SEG_A_BIT ) {
-        lcd_segment_set( lcdmem_base , digit_segments.SEG_A);
-    } else {
-        lcd_segment_clear(lcdmem_base , digit_segments.SEG_A);
-    }
-
-    if ( glyph & SEG_B_BIT ) {
-        lcd_segment_set( lcdmem_base , digit_segments.SEG_B);
-    } else {
-        lcd_segment_clear(lcdmem_base , digit_segments.SEG_B);
-    }
-
-    if ( glyph & SEG_C_BIT ) {
-        lcd_segment_set( lcdmem_base , digit_segments.SEG_C);
-    } else {
-        lcd_segment_clear(lcdmem_base , digit_segments.SEG_C);
-    }
-
-    if ( glyph & SEG_D_BIT ) {
-        lcd_segment_set( lcdmem_base , digit_segments.SEG_D);
-    } else {
-        lcd_segment_clear(lcdmem_base , digit_segments.SEG_D);
-    }
-
-    if ( glyph & SEG_E_BIT ) {
-        lcd_segment_set( lcdmem_base , digit_segments.SEG_E);
-    } else {
-        lcd_segment_clear(lcdmem_base , digit_segments.SEG_E);
-    }
-
-    if ( glyph & SEG_F_BIT ) {
-        lcd_segment_set( lcdmem_base , digit_segments.SEG_F);
-    } else {
-        lcd_segment_clear(lcdmem_base , digit_segments.SEG_F);
-    }
-
-    if ( glyph & SEG_G_BIT ) {
-        lcd_segment_set( lcdmem_base , digit_segments.SEG_G);
-    } else {
-        lcd_segment_clear(lcdmem_base , digit_segments.SEG_G);
-    }
-
-}
-
-
-// General function to write a glyph onto the LCD. No constraints on how pins are connected, but inefficient.
-// Remember that means that different segments in the same digit could be at different LCDMEM locations!
-
-void lcd_write_glyph_to_lcdmem( byte digitplace, glyph_segment_t glyph ) {
-
-    lcd_write_glyph_to_lcdmem( LCDMEM , digitplace, glyph);
-
-}
-
-
-// Write a glyph to the blinking LCD buffer
-
-void lcd_write_glyph_to_lcdbm( byte digitplace, glyph_segment_t glyph ) {
-
-    lcd_write_glyph_to_lcdmem( LCDBMEM , digitplace, glyph);
-
-}
-
-void lcd_write_blank( char *lcdmem_base , byte digitplace ) {
-
-    lcd_digit_segments_t digit_segments = lcd_digit_segments[ digitplace ];
-
-    lcd_segment_clear( lcdmem_base , digit_segments.SEG_A);
-    lcd_segment_clear( lcdmem_base , digit_segments.SEG_B);
-    lcd_segment_clear( lcdmem_base , digit_segments.SEG_C);
-    lcd_segment_clear( lcdmem_base , digit_segments.SEG_D);
-    lcd_segment_clear( lcdmem_base , digit_segments.SEG_E);
-    lcd_segment_clear( lcdmem_base , digit_segments.SEG_F);
-    lcd_segment_clear( lcdmem_base , digit_segments.SEG_G);
-
-}
-
-
-
-void lcd_write_blank_to_lcdmem( byte digitplace ) {
-
-    lcd_write_blank(LCDMEM, digitplace);
-
-}
-
-
-void lcd_write_blank_to_lcdbm( byte digitplace ) {
-
-    lcd_write_blank(LCDBMEM, digitplace);
-
-}
-
-
 // Do a hardware clear of the LCD memory
 // Note this does block until the hardware indicates that the clear is complete.
 // TODO: Check how long this takes.
@@ -321,16 +219,232 @@ struct ConstexprArray {
 };
 
 
-// This function will generate the words that will go into the compile time cache arrays
+// Precomputed words for writing a single glyph into a single digitplace.
+// Every digitplace is wired so all 7 of its segments are in one LCDMEM word (checked below), so a glyph write is one BIC of the
+// digitplace's mask and one BIS of the glyph's bits into that word, rather than 7 segment read-modify-writes.
+// A table of every digitplace x every 7-bit glyph would be 1.5KB, so we split the glyph into its low nibble (segments A-D)
+// and its high 3 bits (segments E-G) and OR the two looked up words together.
 
-template < int tens_digitplace ,  int ones_digitplace , int radix >
-constexpr unsigned int generate_lcd_cache_word( unsigned int number ) {
+constexpr unsigned LCD_GLYPH_LO_COUNT = 0x10;          // Segments A-D
+constexpr unsigned LCD_GLYPH_HI_COUNT = 0x08;          // Segments E-G
+
+static_assert( ( SEG_A_BIT | SEG_B_BIT | SEG_C_BIT | SEG_D_BIT ) == LCD_GLYPH_LO_COUNT - 1 , "Segments A-D should be the low nibble of a glyph" );
+static_assert( ( SEG_E_BIT | SEG_F_BIT | SEG_G_BIT ) == ( LCD_GLYPH_HI_COUNT - 1 ) << 4 , "Segments E-G should be the next 3 bits of a glyph" );
+
+constexpr bool test_all_digitplaces_contained_in_one_word() {
+
+    for ( unsigned digitplace = 0; digitplace < DIGITPLACE_COUNT; digitplace++ ) {
+        if ( !test_all_digit_segments_contained_in_one_word( lcd_digit_segments[ digitplace ] ) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static_assert( test_all_digitplaces_contained_in_one_word() , "All of the segments in each digitplace must be in the same LCDMEM word for the masked glyph writer to work" );
+
+constexpr unsigned int generate_lcd_digit_word_offset( unsigned int digitplace ) {
+    return lcd_layout_digit_word( digitplace );
+}
+
+constexpr unsigned int generate_lcd_digit_frame_word( unsigned int digitplace ) {
+    return lcd_layout_frame_word( digitplace );
+}
+
+constexpr unsigned int generate_lcd_digit_mask( unsigned int digitplace ) {
+    return glyph_bits( lcd_digit_segments[ digitplace ] , SEG_A_BIT | SEG_B_BIT | SEG_C_BIT | SEG_D_BIT | SEG_E_BIT | SEG_F_BIT | SEG_G_BIT );
+}
+
+// Entry (digitplace*LCD_GLYPH_LO_COUNT)+n has the bits for segments A-D of glyph n
+
+constexpr unsigned int generate_lcd_glyph_lo_word( unsigned int entry ) {
+    return glyph_bits( lcd_digit_segments[ entry / LCD_GLYPH_LO_COUNT ] , entry % LCD_GLYPH_LO_COUNT );
+}
+
+// Entry (digitplace*LCD_GLYPH_HI_COUNT)+n has the bits for segments E-G of glyph (n<<4)
+
+constexpr unsigned int generate_lcd_glyph_hi_word( unsigned int entry ) {
+    return glyph_bits( lcd_digit_segments[ entry / LCD_GLYPH_HI_COUNT ] , ( entry % LCD_GLYPH_HI_COUNT ) << 4 );
+}
+
+constexpr auto lcd_digit_word_offsets_struct = ConstexprArray< generate_lcd_digit_word_offset , DIGITPLACE_COUNT >();
+constexpr auto lcd_digit_frame_words_struct  = ConstexprArray< generate_lcd_digit_frame_word  , DIGITPLACE_COUNT >();
+constexpr auto lcd_digit_masks_struct        = ConstexprArray< generate_lcd_digit_mask        , DIGITPLACE_COUNT >();
+constexpr auto lcd_glyph_lo_words_struct     = ConstexprArray< generate_lcd_glyph_lo_word     , DIGITPLACE_COUNT * LCD_GLYPH_LO_COUNT >();
+constexpr auto lcd_glyph_hi_words_struct     = ConstexprArray< generate_lcd_glyph_hi_word     , DIGITPLACE_COUNT * LCD_GLYPH_HI_COUNT >();
+
+constexpr const unsigned int * const lcd_digit_word_offsets = lcd_digit_word_offsets_struct.array;
+constexpr const unsigned int * const lcd_digit_frame_words  = lcd_digit_frame_words_struct.array;          // Which lcd_frame_t word holds each digitplace
+constexpr const unsigned int * const lcd_digit_masks        = lcd_digit_masks_struct.array;
+constexpr const unsigned int * const lcd_glyph_lo_words     = lcd_glyph_lo_words_struct.array;
+constexpr const unsigned int * const lcd_glyph_hi_words     = lcd_glyph_hi_words_struct.array;
+
+
+// General function to write a glyph onto memory. That could be main LCDMEM or "blinking" LCDBM
+// which can also be used for double buffering.
+// Clears the digitplace's segments with one BIC and sets the glyph's with one BIS. Any other segments in the word (like the colon) are left alone.
+
+inline unsigned int lcd_glyph_word_bits( const byte digitplace , const glyph_segment_t glyph ) {
+
+    return lcd_glyph_lo_words[ ( digitplace * LCD_GLYPH_LO_COUNT ) + ( glyph & ( LCD_GLYPH_LO_COUNT - 1 ) ) ] |
+           lcd_glyph_hi_words[ ( digitplace * LCD_GLYPH_HI_COUNT ) + ( ( glyph >> 4 ) & ( LCD_GLYPH_HI_COUNT - 1 ) ) ];
+
+}
+
+void lcd_write_glyph_to_lcdmem( char *lcdmem_base , byte digitplace, glyph_segment_t glyph ) {
+
+    word * const lcdmemw = ( (word *) lcdmem_base ) + lcd_digit_word_offsets[ digitplace ];
+
+    const unsigned int bits = lcd_glyph_word_bits( digitplace , glyph );
+
+    *lcdmemw &= ~lcd_digit_masks[ digitplace ];             // BIC
+    *lcdmemw |= bits;                                       // BIS
+
+}
+
+
+// Draw a glyph into a frame in RAM. pos=0 is the rightmost digit, like lcd_show_f().
+
+void lcd_frame_set_glyph( lcd_frame_t &frame , const uint8_t pos , const glyph_segment_t glyph ) {
+
+    const byte digitplace = digit_positions_rj( pos );
+
+    unsigned int &w = frame.words[ lcd_digit_frame_words[ digitplace ] ];
+
+    w &= ~lcd_digit_masks[ digitplace ];
+    w |= lcd_glyph_word_bits( digitplace , glyph );
+
+}
+
+
+void lcd_write_blank( char *lcdmem_base , byte digitplace ) {
+
+    word * const lcdmemw = ( (word *) lcdmem_base ) + lcd_digit_word_offsets[ digitplace ];
+
+    *lcdmemw &= ~lcd_digit_masks[ digitplace ];             // BIC
+
+}
+
+
+// General function to write a glyph onto the LCD.
+
+void lcd_write_glyph_to_lcdmem( byte digitplace, glyph_segment_t glyph ) {
+
+    lcd_write_glyph_to_lcdmem( LCDMEM , digitplace, glyph);
+
+}
+
+
+// Write a glyph to the blinking LCD buffer
+
+void lcd_write_glyph_to_lcdbm( byte digitplace, glyph_segment_t glyph ) {
+
+    lcd_write_glyph_to_lcdmem( LCDBMEM , digitplace, glyph);
+
+}
+
+void lcd_write_blank_to_lcdmem( byte digitplace ) {
+
+    lcd_write_blank(LCDMEM, digitplace);
+
+}
+
+
+void lcd_write_blank_to_lcdbm( byte digitplace ) {
+
+    lcd_write_blank(LCDBMEM, digitplace);
+
+}
+
+
+// returns true if the segment is in the same LCDMEM word as all of the segments in the digit place.
+// We use this to check that we can also light up decorations like the colon in the same single write as the digits.
+
+constexpr bool test_segment_contained_in_digit_word( const lcd_segment_location_t segment , const lcd_digit_segments_t digitplace_segments ) {
+
+    return test_all_digit_segments_contained_in_one_word( digitplace_segments ) &&
+           LCDMEMW_OFFSET_FOR_LPIN( lcdpin_to_lpin[ segment.lcd_pin ] ) == LCDMEMW_OFFSET_FOR_LPIN( lcdpin_to_lpin[ digitplace_segments.SEG_A.lcd_pin ] );
+
+}
+
+
+// Which way the numbers go as you walk up a table. Lets the ISRs always walk with post-increment (@Rn+) no matter which way they count.
+enum class lcd_table_direction_t {
+    UP,
+    DOWN,
+};
+
+// How an entry in a table is indexed
+enum class lcd_table_index_t {
+    BINARY,         // Entry n is the n'th number in the walk (see direction and start above)
+    BCD,            // Entry n is the number whose BCD encoding is n (so 0x23 shows "23"). Non-BCD entries are blank. Direction and start must be left at their defaults.
+};
+
+// How many entries are in a table for the range first-last
+
+constexpr unsigned int lcd_table_size( unsigned int first , unsigned int last , lcd_table_index_t index , int radix ) {
+    return ( index == lcd_table_index_t::BCD ) ? ( ( ( last / radix ) << 4 ) | ( last % radix ) ) + 1 : ( last - first ) + 1;
+}
+
+
+// This function will generate the words that will go into the compile time cache arrays
+//
+// tens_digitplace , ones_digitplace - where the two digits go on the LCD. A word in the table only makes sense if they are a fast pair (see lcd_layout.h).
+// radix      - base of the displayed number (DEC or HEX)
+// first,last - the range of numbers in the table, inclusive
+// direction  - which way the numbers go as the entry index goes up. Numbers wrap around inside the range.
+// start      - the number in entry 0. So a countdown table for secs with start=58 goes 58,57,...,01,00,59 and the rollover entry ends up last.
+// index      - BINARY or BCD (see above)
+// decoration - optional extra segment (like the colon) that is lit in every entry. Must be in the same LCDMEM word as the ones digit.
+
+template < int tens_digitplace ,  int ones_digitplace , int radix ,
+           unsigned int first , unsigned int last ,
+           lcd_table_direction_t direction = lcd_table_direction_t::UP ,
+           unsigned int start = ( direction == lcd_table_direction_t::UP ) ? first : last ,
+           lcd_table_index_t index = lcd_table_index_t::BINARY ,
+           const lcd_segment_location_t *decoration = nullptr >
+constexpr unsigned int generate_lcd_table_word( unsigned int entry ) {
 
     constexpr lcd_digit_segments_t ones_digitplace_segments = lcd_digit_segments[ones_digitplace];
     constexpr lcd_digit_segments_t tens_digitplace_segments = lcd_digit_segments[tens_digitplace];
 
-    // Cross check to make sure the current LCD layout and connections are compatible with this optimization
-    static_assert( test_all_digit_segments_contained_in_one_word(  tens_digitplace_segments,  ones_digitplace_segments )   , "All of the segments in the seconds ones and tens digits must be in the same LCDMEM word for this optimization to work" );
+    // If the two digits are not a fast pair (see lcd_layout.h) then no single word can show them, but we still build the table
+    // so that everything compiles. The C side only uses these through lcd_frame_set_pair(), which falls back to per-digit writes then.
+    static_assert( decoration == nullptr || test_segment_contained_in_digit_word( *decoration , ones_digitplace_segments ) , "The decoration segment must be in the same LCDMEM word as the ones digit" );
+
+    static_assert( first <= start && start <= last , "Start must be inside the range" );
+    static_assert( last < radix * radix , "Only two digits to show the number in" );
+    static_assert( index == lcd_table_index_t::BINARY || ( direction == lcd_table_direction_t::UP && start == first ) , "BCD tables are indexed by value so they can not have a direction or start" );
+
+    constexpr unsigned int range = ( last - first ) + 1;
+
+    unsigned int number = 0;
+
+    if ( index == lcd_table_index_t::BCD ) {
+
+        unsigned int bcd_tens = entry >> 4;
+        unsigned int bcd_ones = entry & 0x0f;
+
+        if ( bcd_ones >= radix ) {
+            return 0;                                   // Not a valid BCD value, so should never be displayed
+        }
+
+        number = ( bcd_tens * radix ) + bcd_ones;
+
+        if ( number < first ) {
+            return 0;                                   // Outside the range, so should never be displayed
+        }
+
+    } else if ( direction == lcd_table_direction_t::UP ) {
+
+        number = first + ( ( ( start - first ) + entry ) % range );
+
+    } else {
+
+        number = first + ( ( ( start - first ) + ( range - ( entry % range ) ) ) % range );
+
+    }
 
     unsigned int tens_digit = number / radix;
     unsigned int ones_digit = number - ( tens_digit * radix );
@@ -340,166 +454,672 @@ constexpr unsigned int generate_lcd_cache_word( unsigned int number ) {
 
     unsigned int ones_digitplace_bits = glyph_bits( ones_digitplace_segments , digit_glyphs[ ones_digit ] );
 
+    unsigned int decoration_bits = ( decoration != nullptr ) ? word_bits_for_segment( *decoration ) : 0;
+
     // Combines all the segments that need to be lit to show this two digit number
-    return  tens_digitplace_bits | ones_digitplace_bits;
+    return  tens_digitplace_bits | ones_digitplace_bits | decoration_bits;
+
+}
+
+
+// The original plain table - entry n shows the number n, from 00 up to 99 (for DEC)
+
+template < int tens_digitplace ,  int ones_digitplace , int radix >
+constexpr unsigned int generate_lcd_cache_word( unsigned int number ) {
+
+    return generate_lcd_table_word< tens_digitplace , ones_digitplace , radix , 0 , ( radix * radix ) - 1 >( number );
+
+}
+
+
+// these arrays hold the pre-computed words that we will write to word in LCD memory that
+// contain the pairs of seconds and mins digits on the LCD. We keep these in RAM intentionally for power and latency savings.
+// use fill_lcd_words() to fill these arrays.
+// Assumes the numbers are base 10.
+
+constexpr unsigned int DEC = 10;
+constexpr unsigned int HEX = 16;
+
+constexpr unsigned int size = 100;
+
+
+// Define and compile-time fill the LCD cache arrays. Note these are only good as single words for fast pairs (see lcd_layout.h).
+constexpr auto secs_lcd_word_cache_struct  = ConstexprArray< generate_lcd_cache_word< SECS_TENS_DIGITPLACE  , SECS_ONES_DIGITPLACE  , DEC  >, size >();
+constexpr auto mins_lcd_word_cache_struct  = ConstexprArray< generate_lcd_cache_word< MINS_TENS_DIGITPLACE  , MINS_ONES_DIGITPLACE  , DEC  >, size >();
+constexpr auto hours_lcd_word_cache_struct = ConstexprArray< generate_lcd_cache_word< HOURS_TENS_DIGITPLACE , HOURS_ONES_DIGITPLACE , DEC  >, size >();
+
+
+// Make the addresses of the cache arrays available to ASM IST
+#pragma RETAIN
+constexpr const unsigned int * const secs_lcd_words =secs_lcd_word_cache_struct.array;
+#pragma RETAIN
+constexpr const unsigned int * const mins_lcd_words =mins_lcd_word_cache_struct.array;
+#pragma RETAIN
+constexpr const unsigned int * const hours_lcd_words =hours_lcd_word_cache_struct.array;
+
+
+// The countdown tables count down and are rotated so that the entry that shows the rollover (59 or 23) is last. This way COUNTDOWN_MODE_ISR can
+// walk up them with post-increment and only check for rollover when the pointer hits the end of the table.
+// The mins and hours words also light up the decimal point and colon so we get "HH:MM.SS" for free on each write.
+
+constexpr auto secs_countdown_lcd_word_struct  = ConstexprArray< generate_lcd_table_word< SECS_TENS_DIGITPLACE  , SECS_ONES_DIGITPLACE  , DEC , 0 , 59 , lcd_table_direction_t::DOWN , 58                                                 >, COUNTDOWN_SECS_TABLE_SIZE  >();
+constexpr auto mins_countdown_lcd_word_struct  = ConstexprArray< generate_lcd_table_word< MINS_TENS_DIGITPLACE  , MINS_ONES_DIGITPLACE  , DEC , 0 , 59 , lcd_table_direction_t::DOWN , 58 , lcd_table_index_t::BINARY , &lcd_segment_dot1 >, COUNTDOWN_MINS_TABLE_SIZE  >();
+constexpr auto hours_countdown_lcd_word_struct = ConstexprArray< generate_lcd_table_word< HOURS_TENS_DIGITPLACE , HOURS_ONES_DIGITPLACE , DEC , 0 , 23 , lcd_table_direction_t::DOWN , 22 , lcd_table_index_t::BINARY , &lcd_segment_col1 >, COUNTDOWN_HOURS_TABLE_SIZE >();
+
+static_assert( lcd_table_size( 0 , 59 , lcd_table_index_t::BINARY , DEC ) == COUNTDOWN_SECS_TABLE_SIZE  , "COUNTDOWN_SECS_TABLE_SIZE does not match the range"  );
+static_assert( lcd_table_size( 0 , 59 , lcd_table_index_t::BINARY , DEC ) == COUNTDOWN_MINS_TABLE_SIZE  , "COUNTDOWN_MINS_TABLE_SIZE does not match the range"  );
+static_assert( lcd_table_size( 0 , 23 , lcd_table_index_t::BINARY , DEC ) == COUNTDOWN_HOURS_TABLE_SIZE , "COUNTDOWN_HOURS_TABLE_SIZE does not match the range" );
+
+#pragma RETAIN
+constexpr const unsigned int * const secs_countdown_lcd_words  = secs_countdown_lcd_word_struct.array;
+#pragma RETAIN
+constexpr const unsigned int * const mins_countdown_lcd_words  = mins_countdown_lcd_word_struct.array;
+#pragma RETAIN
+constexpr const unsigned int * const hours_countdown_lcd_words = hours_countdown_lcd_word_struct.array;
+
+// Find the entry in a countdown table that shows the number n. Remember entry 0 is (size-2) and the last entry is (size-1).
+
+constexpr unsigned int countdown_table_entry( unsigned int n , unsigned int size ) {
+    return ( n == size-1 ) ? n : ( size-2 ) - n;
+}
+
+
+// Make the addresses where you should write the cached values to in order to display the specified secs on the LCD
+// Note that we can take any pin (we picked SEG_A) since the above compile time checks ensure that any of the segments would produce the same address
+#pragma RETAIN
+unsigned int *secs_lcdmemw =&( LCDMEMW[  ( LCDMEMW_OFFSET_FOR_LPIN( lcdpin_to_lpin[  lcd_digit_segments[ SECS_ONES_DIGITPLACE ].SEG_A.lcd_pin ] ) ) ] );
+#pragma RETAIN
+unsigned int *mins_lcdmemw =&( LCDMEMW[  ( LCDMEMW_OFFSET_FOR_LPIN( lcdpin_to_lpin[  lcd_digit_segments[ MINS_ONES_DIGITPLACE ].SEG_A.lcd_pin ] ) ) ] );
+#pragma RETAIN
+unsigned int *hours_lcdmemw =&( LCDMEMW[  ( LCDMEMW_OFFSET_FOR_LPIN( lcdpin_to_lpin[  lcd_digit_segments[ HOURS_ONES_DIGITPLACE ].SEG_A.lcd_pin ] ) ) ] );
+
+// Which pairs got the fast path, for checking a new layout in the debugger or the map file
+#pragma RETAIN
+const unsigned lcd_layout_fast_pair_mask = lcd_layout_fast_pairs();
+
+#ifndef LCD_LAYOUT_BRINGUP
+
+// The asm ISRs write each of the HH, MM, and SS pairs with a single MOV into a whole word, so unlike the C side they can not
+// fall back for a pair that is not fast (see lcd_layout.h). If you are bringing up new glass this is the assert to look at.
+static_assert( lcd_layout_fast_pairs() == LCD_LAYOUT_PAIRS_ALL , "The asm ISRs need the hours, mins, and secs digit pairs to each have a LCDMEM word to themselves (see lcd_layout_fast_pairs())" );
+
+// The asm ISRs can not see the above pointers at assemble time, so they use hardcoded offsets from lcd_display_exp.h. Make sure those still match the pinout.
+static_assert( LCDMEMW_OFFSET_FOR_LPIN( lcdpin_to_lpin[  lcd_digit_segments[ SECS_ONES_DIGITPLACE  ].SEG_A.lcd_pin ] ) * 2 == SECS_LCDMEM_OFFSET  , "SECS_LCDMEM_OFFSET does not match the LCD pinout"  );
+static_assert( LCDMEMW_OFFSET_FOR_LPIN( lcdpin_to_lpin[  lcd_digit_segments[ MINS_ONES_DIGITPLACE  ].SEG_A.lcd_pin ] ) * 2 == MINS_LCDMEM_OFFSET  , "MINS_LCDMEM_OFFSET does not match the LCD pinout"  );
+static_assert( LCDMEMW_OFFSET_FOR_LPIN( lcdpin_to_lpin[  lcd_digit_segments[ HOURS_ONES_DIGITPLACE ].SEG_A.lcd_pin ] ) * 2 == HOURS_LCDMEM_OFFSET , "HOURS_LCDMEM_OFFSET does not match the LCD pinout" );
+
+// lcd_frame_t promises that frame words 0, 1, and 2 are the hours, mins, and secs, which are the same words the asm ISRs write.
+static_assert( lcd_layout_word_offset( 0 ) * 2 == HOURS_LCDMEM_OFFSET , "Frame word 0 should be the hours word" );
+static_assert( lcd_layout_word_offset( 1 ) * 2 == MINS_LCDMEM_OFFSET  , "Frame word 1 should be the mins word"  );
+static_assert( lcd_layout_word_offset( 2 ) * 2 == SECS_LCDMEM_OFFSET  , "Frame word 2 should be the secs word"  );
+
+#endif
+
+
+
+// A whole screen of digit glyphs, precomputed at compile time as the LCDMEM words that hold them.
+// There is one frame word for each LCDMEM word that has any digits in it (see lcd_layout.h). On this glass the digits are
+// wired in pairs that each live in one word, so a screen is only DIGITPLACE_COUNT/2 words and showing one is just that many word stores.
+// Note that a frame owns the whole word, so showing one also clears the colon and decimal point.
+
+// lcd_frame_t is in lcd_display.h so callers can draw into one and lcd_commit_frame() it.
+
+// Which LCDMEMW word holds frame word n
+
+constexpr unsigned int generate_lcd_frame_word_offset( unsigned int n ) {
+    return lcd_layout_word_offset( n );
+}
+
+constexpr auto lcd_frame_word_offsets_struct = ConstexprArray< generate_lcd_frame_word_offset , LCD_FRAME_WORD_COUNT >();
+
+constexpr const unsigned int * const lcd_frame_word_offsets = lcd_frame_word_offsets_struct.array;
+
+// Build a frame from DIGITPLACE_COUNT glyphs, leftmost first (the same order we write the messages in)
+
+constexpr lcd_frame_t lcd_frame( const glyph_segment_t *glyphs ) {
+
+    lcd_frame_t frame = {};
+
+    for ( unsigned digitplace = 0; digitplace < DIGITPLACE_COUNT; digitplace++ ) {
+        frame.words[ lcd_layout_frame_word( digitplace ) ] |= glyph_bits( lcd_digit_segments[ digitplace ] , glyphs[ digitplace ] );
+    }
+
+    return frame;
+}
+
+// Build a frame with the same glyph in every digitplace
+
+constexpr lcd_frame_t lcd_frame_fill( const glyph_segment_t glyph ) {
+
+    lcd_frame_t frame = {};
+
+    for ( unsigned digitplace = 0; digitplace < DIGITPLACE_COUNT; digitplace++ ) {
+        frame.words[ lcd_layout_frame_word( digitplace ) ] |= glyph_bits( lcd_digit_segments[ digitplace ] , glyph );
+    }
+
+    return frame;
+}
+
+// Put a two digit number (<100) into a frame. A fast pair (see lcd_layout.h) gets its word straight out of `table`, which must be
+// one of the tables above for these digitplaces, with `entry` being the one that shows `number`. That word already has the decoration in it.
+// Otherwise we mask each digit into its own word and OR the decoration into whichever word the layout puts it in.
+
+template < int tens_digitplace , int ones_digitplace , const lcd_segment_location_t *decoration = nullptr >
+inline void lcd_frame_set_pair( lcd_frame_t &frame , const unsigned int *table , const unsigned entry , const unsigned number ) {
+
+    // Pinned down as constexpr so none of the layout loops ever run on the MSP430
+    constexpr bool fast = lcd_layout_pair_fast( tens_digitplace , ones_digitplace );
+    constexpr unsigned tens_word = lcd_layout_frame_word( tens_digitplace );
+    constexpr unsigned ones_word = lcd_layout_frame_word( ones_digitplace );
+    constexpr unsigned int decoration_bits = ( decoration != nullptr ) ? word_bits_for_segment( *decoration ) : 0;
+    constexpr unsigned decoration_word = ( decoration != nullptr ) ? lcd_layout_segment_frame_word( *decoration ) : ones_word;
+
+    static_assert( decoration_word < LCD_FRAME_WORD_COUNT , "The decoration segment must be in a LCDMEM word that has digits in it so a frame can hold it" );
+
+    if ( fast ) {
+
+        frame.words[ ones_word ] = table[ entry ];
+
+    } else {
+
+        const uint8_t bcd = bin_to_bcd( number );
+
+        frame.words[ tens_word ] &= ~lcd_digit_masks[ tens_digitplace ];
+        frame.words[ tens_word ] |= lcd_glyph_word_bits( tens_digitplace , digit_glyphs[ bcd >> 4 ] );
+
+        frame.words[ ones_word ] &= ~lcd_digit_masks[ ones_digitplace ];
+        frame.words[ ones_word ] |= lcd_glyph_word_bits( ones_digitplace , digit_glyphs[ bcd & 0x0f ] );
+
+        frame.words[ decoration_word ] |= decoration_bits;
+
+    }
+
+}
+
+#ifdef LCD_COMMIT_STATS
+
+// Running totals so we can see how much LCD memory traffic each mode makes. Read them in the debugger.
+volatile unsigned long lcd_commit_count;
+volatile unsigned long lcd_commit_words_written;
+
+#endif
+
+inline void lcd_count_commit( const unsigned written ) {
+
+    #ifdef LCD_COMMIT_STATS
+        lcd_commit_count++;
+        lcd_commit_words_written += written;
+    #endif
+
+}
+
+// Write a frame into the LCDMEM or LCDBMEM bank, skipping any words that already match.
+// LCD memory is plain RAM on this chip (reads cost the same as reading a RAM copy), and the asm ISRs write straight into it,
+// so the bank itself is our shadow. That way the shadow can never go stale behind our back.
+// Returns how many words were actually written.
+
+unsigned lcd_commit_frame( char *lcdmem_base , const lcd_frame_t &frame ) {
+
+    word * const lcdmemw = (word *) lcdmem_base;
+
+    unsigned written = 0;
+
+    for ( unsigned n = 0; n < LCD_FRAME_WORD_COUNT; n++ ) {
+
+        word * const w = lcdmemw + lcd_frame_word_offsets[ n ];
+
+        if ( *w != frame.words[n] ) {
+            *w = frame.words[n];
+            written++;
+        }
+
+    }
+
+    lcd_count_commit( written );
+
+    return written;
+}
+
+// Show a frame in the main LCDMEM bank
+
+inline void lcd_show_frame( const lcd_frame_t &frame ) {
+
+    lcd_commit_frame( LCDMEM , frame );
+
+}
+
+
+// Show the digit x at position p
+// where p=0 is the rightmost digit
+
+template <uint8_t pos, uint8_t x>                    // Use template to force everything to compile down to an individualized, optimized function for each pos+x combination
+inline void lcd_show() {
+
+    uint8_t * const lcd_mem_reg = LCDMEM;
+
+    /*
+      I know that line above looks dumb, but if you just access LCDMEM directly the compiler does the wrong thing and loads the offset
+      into a register rather than the base and this creates many wasted loads (LCDMEM=0x0620)...
+
+            00c4e2:   403F 0010           MOV.W   #0x0010,R15
+            00c4e6:   40FF 0060 0620      MOV.B   #0x0060,0x0620(R15)
+            00c4ec:   403F 000E           MOV.W   #0x000e,R15
+            00c4f0:   40FF 00F2 0620      MOV.B   #0x00f2,0x0620(R15)
+
+      If we load it into a variable first, the compiler then gets wise and uses that as the base..
+
+            00c4e2:   403F 0620           MOV.W   #0x0620,R15
+            00c4e6:   40FF 0060 0010      MOV.B   #0x0060,0x0010(R15)
+            00c4ec:   40FF 00F2 000E      MOV.B   #0x00f2,0x000e(R15)
+
+     */
+
+    constexpr byte digitplace = digit_positions_rj( pos );
+
+    lcd_write_glyph_to_lcdmem( digitplace , digit_glyphs[x] );
+
+}
+
+
+// Show the glyph x at position p
+// where p=0 is the rightmost digit
+
+
+void lcd_show_f( char *lcdmem_base ,  const uint8_t pos, const glyph_segment_t segs ) {
+
+    byte digitplace = digit_positions_rj( pos );
+
+    lcd_write_glyph_to_lcdmem( lcdmem_base , digitplace , segs );
+
+}
+
+
+void lcd_show_f( const uint8_t pos, const glyph_segment_t segs ) {
+
+
+    lcd_show_f( LCDMEM ,  pos , segs );
+
+}
+
+
+void lcd_show_digit_f( const uint8_t pos, const byte d ) {
+
+    lcd_show_f( pos , digit_glyphs[ d ] );
+}
+
+
+void lcd_show_digit_f( char *lcd_base , const uint8_t pos, const byte d ) {
+
+    lcd_show_f( lcd_base , pos , digit_glyphs[ d ] );
+}
+
+
+
+// The days page in LCDBMEM is laid out on the same digit pair words as the HH:MM.SS page, so we can use the same kind of tables.
+// The ones digit shares the secs word with the "d" label, the tens and hundreds are the mins word,
+// and the thousands and ten thousands are the hours word.
+// Leading zeros are blanked by clearing their digitplace out of the word with lcd_digit_masks[].
+
+constexpr unsigned int generate_days_ones_lcd_word( unsigned int digit ) {
+    return glyph_bits( lcd_digit_segments[ SECS_TENS_DIGITPLACE ] , digit_glyphs[ digit ] ) | glyph_bits( lcd_digit_segments[ SECS_ONES_DIGITPLACE ] , glyph_d );
+}
+
+constexpr auto days_ones_lcd_word_struct = ConstexprArray< generate_days_ones_lcd_word , DEC >();
+
+constexpr const unsigned int * const days_ones_lcd_words = days_ones_lcd_word_struct.array;
+
+// The days currently shown in LCDBMEM, in BCD. Lets us step the count and only rewrite the words that changed.
+
+static unsigned long days_lcdbmem_bcd;
+
+static unsigned int days_ones_word( const unsigned long bcd ) {
+
+    return days_ones_lcd_words[ bcd & 0x0f ];
+
+}
+
+static unsigned int days_hundreds_word( const unsigned long bcd ) {
+
+    unsigned int w = mins_lcd_words[ bcd_to_bin( (uint8_t) ( bcd >> 4 ) ) ];          // Hundreds in the mins tens place, tens in the mins ones place
+
+    if ( bcd < 0x100 ) {
+        w &= ~lcd_digit_masks[ MINS_TENS_DIGITPLACE ];
+
+        if ( bcd < 0x10 ) {
+            w &= ~lcd_digit_masks[ MINS_ONES_DIGITPLACE ];
+        }
+    }
+
+    return w;
+
+}
+
+static unsigned int days_thousands_word( const unsigned long bcd ) {
+
+    unsigned int w = hours_lcd_words[ bcd_to_bin( (uint8_t) ( bcd >> 12 ) ) ];        // Ten thousands in the hours tens place, thousands in the hours ones place
+
+    if ( bcd < 0x10000 ) {
+        w &= ~lcd_digit_masks[ HOURS_TENS_DIGITPLACE ];
+
+        if ( bcd < 0x1000 ) {
+            w &= ~lcd_digit_masks[ HOURS_ONES_DIGITPLACE ];
+        }
+    }
+
+    return w;
+
+}
+
+
+// The word tricks above need all three pairs to be fast (see lcd_layout.h). Otherwise we draw the days a digit at a time.
+
+constexpr bool days_fast = ( lcd_layout_fast_pairs() == LCD_LAYOUT_PAIRS_ALL );
+
+constexpr unsigned DAYS_ONES_FRAME_WORD      = lcd_layout_frame_word( SECS_ONES_DIGITPLACE  );
+constexpr unsigned DAYS_HUNDREDS_FRAME_WORD  = lcd_layout_frame_word( MINS_ONES_DIGITPLACE  );
+constexpr unsigned DAYS_THOUSANDS_FRAME_WORD = lcd_layout_frame_word( HOURS_ONES_DIGITPLACE );
+
+constexpr word DAYS_ONES_WORD      = lcd_layout_word_offset( DAYS_ONES_FRAME_WORD      );
+constexpr word DAYS_HUNDREDS_WORD  = lcd_layout_word_offset( DAYS_HUNDREDS_FRAME_WORD  );
+constexpr word DAYS_THOUSANDS_WORD = lcd_layout_word_offset( DAYS_THOUSANDS_FRAME_WORD );
+
+// The days page for the given BCD count. Leading zeros are blank, and the "d" is in the rightmost digit.
+
+static lcd_frame_t days_frame( const unsigned long bcd ) {
+
+    lcd_frame_t frame = {};
+
+    if ( days_fast ) {
+
+        frame.words[ DAYS_THOUSANDS_FRAME_WORD ] = days_thousands_word( bcd );
+        frame.words[ DAYS_HUNDREDS_FRAME_WORD  ] = days_hundreds_word( bcd );
+        frame.words[ DAYS_ONES_FRAME_WORD      ] = days_ones_word( bcd );
+
+    } else {
+
+        // Walk left from the ones digit (which goes just left of the "d") until we run out of digits. We always show at least the ones.
+
+        lcd_frame_set_glyph( frame , 0 , glyph_d );
+
+        unsigned long rest = bcd;
+        uint8_t pos = 1;
+
+        do {
+            lcd_frame_set_glyph( frame , pos , digit_glyphs[ rest & 0x0f ] );
+            rest >>= 4;
+            pos++;
+        } while ( rest && pos < DIGITPLACE_COUNT );
+
+    }
+
+    return frame;
+
+}
+
+// Print the current days value into the LCDBMEM buffer, including the "d" label.
+// Currently leading spaces, but could be leading 0s
+
+void lcd_show_days_lcdbmem( const unsigned days ) {
+
+    // Convert to BCD up front so each digit is just the next nibble (no divides)
+    const unsigned long bcd = bin_to_bcd_long( days );
+
+    days_lcdbmem_bcd = bcd;
+
+    lcd_commit_frame( LCDBMEM , days_frame( bcd ) );
+
+}
+
+
+// Count the days shown in LCDBMEM down by one. Only the ones word changes every day, the tens/hundreds word
+// changes every 10 days, and the thousands word every 1000 days.
+// We already know which words changed from the BCD, so we write them directly rather than building a whole frame to commit.
+// The page must already have been painted with lcd_show_days_lcdbmem(), and must not be showing 0.
+
+void lcd_show_days_lcdbmem_decrement() {
+
+    word * const lcdbmemw = (word *) LCDBMEM;
+
+    const unsigned long old_bcd = days_lcdbmem_bcd;
+    const unsigned long bcd = __bcd_add_long( old_bcd , 0x99999999UL );       // DADD of the ten's complement of 1 is a BCD decrement
+
+    days_lcdbmem_bcd = bcd;
+
+    if ( !days_fast ) {
+        lcd_commit_frame( LCDBMEM , days_frame( bcd ) );        // Let the commit sort out which words changed
+        return;
+    }
+
+    unsigned written = 1;
+
+    lcdbmemw[ DAYS_ONES_WORD ] = days_ones_word( bcd );
+
+    const unsigned long changed = old_bcd ^ bcd;
+
+    if ( changed & 0x00ff0UL ) {
+        lcdbmemw[ DAYS_HUNDREDS_WORD ] = days_hundreds_word( bcd );
+        written++;
+    }
+
+    if ( changed & 0xff000UL ) {
+        lcdbmemw[ DAYS_THOUSANDS_WORD ] = days_thousands_word( bcd );
+        written++;
+    }
+
+    lcd_count_commit( written );
+
+}
+
+
+// Paint HH:MM.SS into the LCDMEM bank using the countdown tables (so we also get the colon and decimal point)
+
+void lcd_show_countdown_hhmmss( const unsigned hours , const unsigned mins , const unsigned secs ) {
+
+    lcd_frame_t frame = {};
+
+    lcd_frame_set_pair< HOURS_TENS_DIGITPLACE , HOURS_ONES_DIGITPLACE , &lcd_segment_col1 >( frame , hours_countdown_lcd_words , countdown_table_entry( hours , COUNTDOWN_HOURS_TABLE_SIZE ) , hours );
+    lcd_frame_set_pair< MINS_TENS_DIGITPLACE  , MINS_ONES_DIGITPLACE  , &lcd_segment_dot1 >( frame , mins_countdown_lcd_words  , countdown_table_entry( mins  , COUNTDOWN_MINS_TABLE_SIZE  ) , mins  );
+    lcd_frame_set_pair< SECS_TENS_DIGITPLACE  , SECS_ONES_DIGITPLACE                      >( frame , secs_countdown_lcd_words  , countdown_table_entry( secs  , COUNTDOWN_SECS_TABLE_SIZE  ) , secs  );
+
+    lcd_commit_frame( LCDMEM , frame );
 
 }
 
+// Paint HH:MM into the LCDMEM bank using the countdown tables, and blank the seconds digits
 
-// these arrays hold the pre-computed words that we will write to word in LCD memory that
-// contain the pairs of seconds and mins digits on the LCD. We keep these in RAM intentionally for power and latency savings.
-// use fill_lcd_words() to fill these arrays.
-// Assumes the numbers are base 10.
+void lcd_show_countdown_hhmm( const unsigned hours , const unsigned mins ) {
 
-constexpr unsigned int DEC = 10;
-constexpr unsigned int HEX = 16;
+    lcd_frame_t frame = {};             // The secs digits stay blank
 
-constexpr unsigned int size = 100;
+    lcd_frame_set_pair< HOURS_TENS_DIGITPLACE , HOURS_ONES_DIGITPLACE , &lcd_segment_col1 >( frame , hours_countdown_lcd_words , countdown_table_entry( hours , COUNTDOWN_HOURS_TABLE_SIZE ) , hours );
+    lcd_frame_set_pair< MINS_TENS_DIGITPLACE  , MINS_ONES_DIGITPLACE  , &lcd_segment_dot1 >( frame , mins_countdown_lcd_words  , countdown_table_entry( mins  , COUNTDOWN_MINS_TABLE_SIZE  ) , mins  );
 
+    lcd_commit_frame( LCDMEM , frame );
 
-// Define and compile-time fill the LCD cache arrays. NOte that these will fail at compile time if the pins layout is not compatible with this optimization.
-constexpr auto secs_lcd_word_cache_struct  = ConstexprArray< generate_lcd_cache_word< SECS_TENS_DIGITPLACE  , SECS_ONES_DIGITPLACE  , DEC  >, size >();
-constexpr auto mins_lcd_word_cache_struct  = ConstexprArray< generate_lcd_cache_word< MINS_TENS_DIGITPLACE  , MINS_ONES_DIGITPLACE  , DEC  >, size >();
-constexpr auto hours_lcd_word_cache_struct = ConstexprArray< generate_lcd_cache_word< HOURS_TENS_DIGITPLACE , HOURS_ONES_DIGITPLACE , DEC  >, size >();
+}
 
+// Clear the colon and decimal point that the countdown tables light up
 
-// Make the addresses of the cache arrays available to ASM IST
-#pragma RETAIN
-constexpr const unsigned int * const secs_lcd_words =secs_lcd_word_cache_struct.array;
-#pragma RETAIN
-constexpr const unsigned int * const mins_lcd_words =mins_lcd_word_cache_struct.array;
-#pragma RETAIN
-constexpr const unsigned int * const hours_lcd_words =hours_lcd_word_cache_struct.array;
+void lcd_clear_countdown_decorations() {
 
+    lcd_segment_clear_to_lcdmem( lcd_segment_dot1 );
+    lcd_segment_clear_to_lcdmem( lcd_segment_col1 );
 
-// Make the addresses where you should write the cached values to in order to display the specified secs on the LCD
-// Note that we can take any pin (we picked SEG_A) since the above compile time checks ensure that any of the segments would produce the same address
-#pragma RETAIN
-unsigned int *secs_lcdmemw =&( LCDMEMW[  ( LCDMEMW_OFFSET_FOR_LPIN( lcdpin_to_lpin[  lcd_digit_segments[ SECS_ONES_DIGITPLACE ].SEG_A.lcd_pin ] ) ) ] );
-#pragma RETAIN
-unsigned int *mins_lcdmemw =&( LCDMEMW[  ( LCDMEMW_OFFSET_FOR_LPIN( lcdpin_to_lpin[  lcd_digit_segments[ MINS_ONES_DIGITPLACE ].SEG_A.lcd_pin ] ) ) ] );
-#pragma RETAIN
-unsigned int *hours_lcdmemw =&( LCDMEMW[  ( LCDMEMW_OFFSET_FOR_LPIN( lcdpin_to_lpin[  lcd_digit_segments[ HOURS_ONES_DIGITPLACE ].SEG_A.lcd_pin ] ) ) ] );
+}
 
 
+void lcd_show_day_label_lcdbmem() {
+    lcd_show_f( LCDBMEM , 0, glyph_d);
+}
 
-// Define a full LCD frame so we can put it into LCD memory in one shot.
-// Note that a frame only includes words of LCD memory that have actual pins used. This is hard coded here and in the
-// RTL_MODE_ISR. There are a total of only 8 words spread across 2 extents. This is driven by the PCB layout.
-// It is faster to copy a sequence of words than try to only set the nibbles that have changed.
 
+constexpr bool secs_fast = lcd_layout_pair_fast( SECS_TENS_DIGITPLACE , SECS_ONES_DIGITPLACE );
 
-// Show the digit x at position p
-// where p=0 is the rightmost digit
+inline void lcd_show_fast_secs( uint8_t secs ) {
 
-template <uint8_t pos, uint8_t x>                    // Use template to force everything to compile down to an individualized, optimized function for each pos+x combination
-inline void lcd_show() {
+    if ( secs_fast ) {
 
-    uint8_t * const lcd_mem_reg = LCDMEM;
+        *secs_lcdmemw = secs_lcd_words[  secs ];
 
-    /*
-      I know that line above looks dumb, but if you just access LCDMEM directly the compiler does the wrong thing and loads the offset
-      into a register rather than the base and this creates many wasted loads (LCDMEM=0x0620)...
+    } else {
 
-            00c4e2:   403F 0010           MOV.W   #0x0010,R15
-            00c4e6:   40FF 0060 0620      MOV.B   #0x0060,0x0620(R15)
-            00c4ec:   403F 000E           MOV.W   #0x000e,R15
-            00c4f0:   40FF 00F2 0620      MOV.B   #0x00f2,0x0620(R15)
+        const uint8_t bcd = bin_to_bcd( secs );
 
-      If we load it into a variable first, the compiler then gets wise and uses that as the base..
+        lcd_write_glyph_to_lcdmem( SECS_TENS_DIGITPLACE , digit_glyphs[ bcd >> 4 ] );
+        lcd_write_glyph_to_lcdmem( SECS_ONES_DIGITPLACE , digit_glyphs[ bcd & 0x0f ] );
 
-            00c4e2:   403F 0620           MOV.W   #0x0620,R15
-            00c4e6:   40FF 0060 0010      MOV.B   #0x0060,0x0010(R15)
-            00c4ec:   40FF 00F2 000E      MOV.B   #0x00f2,0x000e(R15)
+    }
 
-     */
+}
 
-    constexpr byte digitplace = digit_positions_rj( pos );
 
-    lcd_write_glyph_to_lcdmem( digitplace , digit_glyphs[x] );
+// The LCD clock comes straight off the VLO, which varies quite a bit from part to part and also drifts with temperature.
+// So rather than always using the divider that is safe on the slowest VLO, we measure each unit's VLO against the RV3032
+// and pick the biggest divider that keeps the LCD clock at or above the slowest one that did not flicker on the bench
+// (the nominal 10KHz VLO divided by 4, see initLCD()). Each step up in the divider saves a couple hundred nA.
+// That is the room temperature number. See lcd_set_temperature() for the others.
 
-}
+#define LCD_CLOCK_MIN_HZ    2500
 
+// Anything outside this is not a VLO, probably a glitch on CLKOUT, so ignore it. The datasheet VLO is 10KHz nominal.
+#define LCD_VLO_MIN_HZ      5000
+#define LCD_VLO_MAX_HZ      20000
 
-// Show the glyph x at position p
-// where p=0 is the rightmost digit
+#define LCD_CLOCK_DIV_MAX   32                  // LCDDIVx is 5 bits of divide-by-(n+1)
+#define LCD_CLOCK_DIV_MASK  ( ( LCD_CLOCK_DIV_MAX - 1 ) * LCDDIV0 )
 
+static_assert( LCDDIV__4 == ( 3 * LCDDIV0 ) , "LCDDIVx should be the divider minus one" );
 
-void lcd_show_f( char *lcdmem_base ,  const uint8_t pos, const glyph_segment_t segs ) {
+// initLCD() uses this so the LCD comes back at the same rate after being turned off. A reset (which includes waking from
+// dormant mode) puts it back to the bench default until the next lcd_set_clock_from_vlo().
 
-    byte digitplace = digit_positions_rj( pos );
+static unsigned lcd_clock_div = 4;
 
-    lcd_write_glyph_to_lcdmem( lcdmem_base , digitplace , segs );
+static unsigned lcd_clock_min_hz = LCD_CLOCK_MIN_HZ;        // Set by lcd_set_temperature()
 
+static unsigned lcd_clock_div_bits( unsigned div ) {
+    return ( div - 1 ) * LCDDIV0;
 }
 
+// Biggest divider that keeps vlo_hz/div >= lcd_clock_min_hz. No hardware divider, so we count up instead. At most 32 passes.
 
-void lcd_show_f( const uint8_t pos, const glyph_segment_t segs ) {
+static unsigned lcd_clock_div_for_vlo( unsigned vlo_hz ) {
 
+    unsigned div = 1;
+    unsigned need = 2 * lcd_clock_min_hz;      // VLO we would need to go to div+1
 
-    lcd_show_f( LCDMEM ,  pos , segs );
+    while ( div < LCD_CLOCK_DIV_MAX && vlo_hz >= need ) {
+        div++;
+        need += lcd_clock_min_hz;
+    }
 
+    return div;
 }
 
+// Pick the LCD divider for a measured VLO frequency. Returns false (and leaves the divider alone) if the measurement
+// looks bogus, like if CLKOUT was not running.
 
-void lcd_show_digit_f( const uint8_t pos, const byte d ) {
+bool lcd_set_clock_from_vlo( unsigned vlo_hz ) {
 
-    lcd_show_f( pos , digit_glyphs[ d ] );
-}
+    if ( vlo_hz < LCD_VLO_MIN_HZ || vlo_hz > LCD_VLO_MAX_HZ ) {
+        return false;
+    }
 
+    const unsigned div = lcd_clock_div_for_vlo( vlo_hz );
 
-void lcd_show_digit_f( char *lcd_base , const uint8_t pos, const byte d ) {
+    if ( div != lcd_clock_div ) {
 
-    lcd_show_f( lcd_base , pos , digit_glyphs[ d ] );
-}
+        lcd_clock_div = div;
 
+        // "LCDDIVx ... should only be changed while LCDON = 0". The glass is off for a few cycles, nobody will notice.
 
+        const unsigned lcdctl0 = LCDCTL0;
 
-// Print the current days value into the LCDBMEM buffer
-// Currently leading spaces, but could be leading 0s
-// TODO: This could be optimized to use the precomputed 2-digit tables, but is it worth it?
+        LCDCTL0 = lcdctl0 & ~LCDON;
+        LCDCTL0 = ( lcdctl0 & ~( LCDON | LCD_CLOCK_DIV_MASK ) ) | lcd_clock_div_bits( div );
+        LCDCTL0 |= ( lcdctl0 & LCDON );         // Back on if it was. If it was off then initLCD() will turn it on with this divider.
+    }
 
-void lcd_show_days_lcdbmem( const unsigned days ) {
+    return true;
+}
 
-    unsigned x=days;
-    unsigned pow = 10000;
-    unsigned place=5;
+/* WINNER for controlled Vlcd - Uses external TSP7A regulator for Vlcd on R33 */
+// LCD Operation - Charge pump enable, Vlcd=external from R33 pin , charge pump FREQ=/256Hz (lowest). 2.1uA/180uA  @ Vcc=3.5V . Vlcd from TPS7A0228 no blinking.
+#define LCDVCTL_TPS7A       ( LCDCPEN |   (LCDCPFSEL0 | LCDCPFSEL1 | LCDCPFSEL2 | LCDCPFSEL3) )
 
-    // Pad with spaces on left
-    while (pow>x) {
+// LCD Operation - Mode 3, internal 2.96v (VLCD_6), charge pump 256Hz, voltage reference only on 1/256th of the time. ~4.2uA from 3.5V Vcc
+// The voltage step comes from lcd_set_temperature().
+#define LCDVCTL_INTERNAL(vlcd)  ( LCDCPEN | LCDREFEN | (vlcd) | (LCDCPFSEL0 | LCDCPFSEL1 | LCDCPFSEL2 | LCDCPFSEL3) | LCDREFMODE )
 
-        lcd_show_f(LCDBMEM , place, glyph_SPACE);
-        place--;
-        pow=pow/10;
+// Like lcd_clock_div, these go back to the defaults on a reset.
 
-    }
+#ifdef USE_TPS7A_LCD_BIAS
+    static bool lcd_bias_internal = false;
+#else
+    static bool lcd_bias_internal = true;
+#endif
 
+static unsigned lcd_vlcd = VLCD_6;
 
-    while (pow>0) {
-        unsigned char y = x / pow;                  // we know the result of this divide must be less than 10
-        lcd_show_digit_f( LCDBMEM , place , y);
-        place--;
+static unsigned lcd_vctl() {
+    return lcd_bias_internal ? LCDVCTL_INTERNAL( lcd_vlcd ) : LCDVCTL_TPS7A;
+}
 
-        x = x - (y * pow);
-        pow = pow / 10;
+// Put the current bias settings into LCDVCTL if the LCD is on. Otherwise initLCD() will when it turns it on.
 
-    }
+static void lcd_update_vctl() {
 
+    const unsigned lcdctl0 = LCDCTL0;
 
+    if ( lcdctl0 & LCDON ) {
+        // Off while we change it, same as the divider. Not sure it matters for LCDVCTL but it costs nothing.
+        LCDCTL0 = lcdctl0 & ~LCDON;
+        LCDVCTL = lcd_vctl();
+        LCDCTL0 = lcdctl0;
+    }
 }
 
-
-void lcd_show_day_label_lcdbmem() {
-    lcd_show_f( LCDBMEM , 0, glyph_d);
+void lcd_set_bias_internal( bool internal ) {
+    lcd_bias_internal = internal;
+    lcd_update_vctl();
 }
 
+// The glass needs more voltage to get the same contrast when it is cold, and it also gets sluggish, which hides flicker.
+// When it is warm the opposite. So each band gets the lowest VLCD and LCD clock we think it can get away with.
+// The room temperature band is the bench setup from initLCD(), and the others are a step or two either side of it.
+// Note that the VLCD only matters on the internal charge pump. The TPS7A makes 3V no matter what.
+// VLCD_x steps are 60mV (VLCD_3=2.78V, VLCD_6=2.96V, VLCD_7=3.02V).
 
-inline void lcd_show_fast_secs( uint8_t secs ) {
+struct lcd_temperature_band_t {
+    int below_c;                    // Band covers temperatures below this (and at or above the one before)
+    unsigned vlcd;
+    unsigned clock_min_hz;
+};
 
-    *secs_lcdmemw = secs_lcd_words[  secs ];
+#define LCD_TEMPERATURE_BAND_COUNT 4
 
-}
+static const lcd_temperature_band_t lcd_temperature_bands[LCD_TEMPERATURE_BAND_COUNT] = {
+    {   5 , VLCD_8 , 2000 },                        // Cold
+    {  30 , VLCD_6 , LCD_CLOCK_MIN_HZ },            // Room, the bench settings
+    {  40 , VLCD_5 , LCD_CLOCK_MIN_HZ },            // Warm
+    { 128 , VLCD_4 , LCD_CLOCK_MIN_HZ },            // Hot (the RV3032 tops out at 127C)
+};
+
+void lcd_set_temperature( int celsius ) {
+
+    const lcd_temperature_band_t *band = lcd_temperature_bands;
 
+    while ( celsius >= band->below_c && band < &lcd_temperature_bands[LCD_TEMPERATURE_BAND_COUNT-1] ) {
+        band++;
+    }
+
+    lcd_clock_min_hz = band->clock_min_hz;
+
+    if ( band->vlcd != lcd_vlcd ) {
+        lcd_vlcd = band->vlcd;
+        lcd_update_vctl();
+    }
+}
 
 void initLCD() {
 
@@ -542,7 +1162,8 @@ void initLCD() {
     //LCDCTL0 = LCDDIV_1 | LCDSSEL__VLOCLK | LCD4MUX | LCDSON | LCDON | LCDLP ;
 
     // LCD using VLO clock, divide by 4 (on 10KHz from VLO) , 4-mux (LCD4MUX also includes LCDSON), low power waveform. No flicker. Squiggle=1.45uA. Count=2.00uA. I guess not worth the flicker for 0.2uA?
-    LCDCTL0 =  LCDSSEL__VLOCLK | LCDDIV__4 | LCD4MUX | LCDLP ;
+    // The /4 is only the default now. lcd_set_clock_from_vlo() picks the divider for this unit's actual VLO.
+    LCDCTL0 =  LCDSSEL__VLOCLK | lcd_clock_div_bits( lcd_clock_div ) | LCD4MUX | LCDLP ;
 
     // LCD using VLO clock, divide by 5 (on 10KHz from VLO) , 4-mux (LCD4MUX also includes LCDSON), low power waveform. Visible flicker at large view angles. Squiggle=1.35uA. Count=1.83uA
     //LCDCTL0 =  LCDSSEL__VLOCLK | LCDDIV__5 | LCD4MUX | LCDLP ;
@@ -609,19 +1230,8 @@ void initLCD() {
 
 
 
-    #ifdef USE_TPS7A_LCD_BIAS
-
-        /* WINNER for controlled Vlcd - Uses external TSP7A regulator for Vlcd on R33 */
-        // LCD Operation - Charge pump enable, Vlcd=external from R33 pin , charge pump FREQ=/256Hz (lowest). 2.1uA/180uA  @ Vcc=3.5V . Vlcd from TPS7A0228 no blinking.
-        LCDVCTL = LCDCPEN |   (LCDCPFSEL0 | LCDCPFSEL1 | LCDCPFSEL2 | LCDCPFSEL3);
-
-    #else
-
-        // LCD Operation - Mode 3, internal 2.96v, charge pump 256Hz, voltage reference only on 1/256th of the time. ~4.2uA from 3.5V Vcc
-        LCDVCTL = LCDCPEN | LCDREFEN | VLCD_6 | (LCDCPFSEL0 | LCDCPFSEL1 | LCDCPFSEL2 | LCDCPFSEL3) | LCDREFMODE;
-
-
-    #endif
+    // See lcd_set_bias_internal() for the two settings we pick between
+    LCDVCTL = lcd_vctl();
 
 
     LCDMEMCTL |= LCDCLRM;                                      // Clear LCD memory
@@ -691,6 +1301,12 @@ void lcd_on() {
                                 // TODO: This would be faster with a direct immediate write
 }
 
+// Turn off the LCD completely. Only initLCD() brings it back.
+
+void lcd_shutdown() {
+    LCDCTL0 &= ~LCDON;
+}
+
 
 /*
  * Select LCD memory registers for display
@@ -792,6 +1408,22 @@ void lcd_blinking_mode_doublebuffer() {
     LCDBLKCTL = LCDBLKPRE__512 | LCDBLKMOD_3;       // Clock prescaler for blink rate, "11b = Switching between display contents as stored in LCDMx and LCDBMx memory registers."
 }
 
+// Put the LCD into double page buffer mode where the hardware alternates between LCDMEM and LCDBMEM about once per second.
+// Used for the countdown when COUNTDOWN_HARDWARE_PAGE_ROTATION is defined. Starts on the LCDMEM page.
+// COUNTDOWN_MODE_ISR resyncs the divider at the top of each minute so the pages can not wander too far from the ticks.
+
+void lcd_blinking_mode_page_rotation() {
+
+    // "Settings for LCDMXx and LCDBLKPREx should only be changed while LCDBLKMODx = 00."
+    LCDBLKCTL &= ~LCDBLKMOD_3;       // Clear the LCDBLKMODx bits. Also clears the DIV counter and LCDDISP.
+
+    // "LCDBMx: the COM related memory bits should be set according to LCDMx configuration"
+    LCDBM4 =  LCDM4;
+    LCDBM5 =  LCDM5;
+
+    LCDBLKCTL = COUNTDOWN_PAGE_ROTATION_BLKPRE | LCDBLKMOD_3;       // "11b = Switching between display contents as stored in LCDMx and LCDBMx memory registers."
+}
+
 void lcd_blinking_mode_doublebuffer_reset_timer() {
 
     // "The divider generating the blinking frequency fBLINK is reset when LCDBLKMODx = 00."
@@ -805,13 +1437,11 @@ void lcd_blinking_mode_doublebuffer_reset_timer() {
 // For now, show all 9's.
 // TODO: Figure out something better here
 
-void lcd_show_long_now() {
-
-    for( byte i=0; i<DIGITPLACE_COUNT; i++ ) {
+constexpr lcd_frame_t long_now_frame = lcd_frame_fill( glyph_9 );
 
-        lcd_show_digit_f( i , 9 );
+void lcd_show_long_now() {
 
-    }
+    lcd_show_frame( long_now_frame );
 
 }
 
@@ -846,36 +1476,33 @@ void lcd_show_squiggle_frame( byte step ) {
 
 // Fill the screen with horizontal dashes
 
-void lcd_show_dashes() {
+constexpr lcd_frame_t dashes_frame = lcd_frame_fill( glyph_dash );
 
-    for( uint8_t i=0 ; i<DIGITPLACE_COUNT; i++ ) {
+void lcd_show_dashes() {
 
-        lcd_show_f( i , glyph_dash );
+    lcd_show_frame( dashes_frame );
 
-    }
 }
 
 
 // Fill the screen with 0's
 
-void lcd_show_zeros() {
+constexpr lcd_frame_t zeros_frame = lcd_frame_fill( glyph_0 );
 
-    for( uint8_t i=0 ; i<DIGITPLACE_COUNT; i++ ) {
+void lcd_show_zeros() {
 
-        lcd_show_f( i , glyph_0 );
+    lcd_show_frame( zeros_frame );
 
-    }
 }
 
 // Fill the screen with X's
 
-void lcd_show_XXX() {
+constexpr lcd_frame_t xxx_frame = lcd_frame_fill( glyph_X );
 
-    for( uint8_t i=0 ; i<DIGITPLACE_COUNT; i++ ) {
+void lcd_show_XXX() {
 
-        lcd_show_f( i , glyph_X );
+    lcd_show_frame( xxx_frame );
 
-    }
 }
 
 
@@ -895,12 +1522,12 @@ constexpr glyph_segment_t testingonly_message[] = {
                                                    glyph_y,
 };
 
+constexpr lcd_frame_t testingonly_frame = lcd_frame( testingonly_message );
+
 
 void lcd_show_testing_only_message() {
 
-    for( byte i=0; i<DIGITPLACE_COUNT; i++ ) {
-        lcd_show_f(  i , testingonly_message[ DIGITPLACE_COUNT - 1- i] );        // digit place 12 is rightmost, so reverse order for text
-    }
+    lcd_show_frame( testingonly_frame );
 
 }
 
@@ -923,13 +1550,13 @@ constexpr glyph_segment_t batt_errorcode_message[] = {
 
 };
 
+constexpr lcd_frame_t batt_errorcode_frame = lcd_frame( batt_errorcode_message );
+
 // Show the message "bAtt Error X" on the lcd.
 
 void lcd_show_batt_errorcode( byte code  ) {
 
-    for( byte i=0; i<DIGITPLACE_COUNT; i++ ) {
-        lcd_show_f(  i , batt_errorcode_message[ DIGITPLACE_COUNT - 1- i] );        // digit place 12 is rightmost, so reverse order for text
-    }
+    lcd_show_frame( batt_errorcode_frame );
 
     lcd_show_digit_f( 0 , code );
 
@@ -954,13 +1581,13 @@ constexpr glyph_segment_t errorcode_message[] = {
 
 };
 
+constexpr lcd_frame_t errorcode_frame = lcd_frame( errorcode_message );
+
 // Show the message "Error X" on the lcd.
 
 void lcd_show_errorcode( byte code  ) {
 
-    for( byte i=0; i<DIGITPLACE_COUNT; i++ ) {
-        lcd_show_f(  i , errorcode_message[ DIGITPLACE_COUNT - 1- i] );        // digit place 12 is rightmost, so reverse order for text
-    }
+    lcd_show_frame( errorcode_frame );
 
     lcd_show_digit_f( 0 , code );
 
@@ -983,47 +1610,264 @@ constexpr glyph_segment_t load_pin_message[] = {
                                                  glyph_SPACE,
 };
 
+constexpr lcd_frame_t load_pin_frame = lcd_frame( load_pin_message );
+
 
 void lcd_show_load_pin_message() {
 
-    for( byte i=0; i<DIGITPLACE_COUNT; i++ ) {
-        lcd_show_f(  i , load_pin_message[ DIGITPLACE_COUNT - 1- i] );        // digit place 0 is rightmost, so reverse order for text
+    lcd_show_frame( load_pin_frame );
+
+}
+
+// Animations are tables of frames, each one the LCD_FRAME_WORD_COUNT digit words that lcd_commit_frame() copies into LCDMEM.
+// It is faster to copy a sequence of words than try to only set the nibbles that have changed.
+
+// Generate entry n of an animation table. glyph_for(frame,digitplace) says what to show.
+
+template < glyph_segment_t (*glyph_for)( unsigned frame , unsigned digitplace ) >
+constexpr unsigned int generate_lcd_animation_word( unsigned int entry ) {
+
+    const unsigned frame = entry / LCD_FRAME_WORD_COUNT;
+    const unsigned n     = entry % LCD_FRAME_WORD_COUNT;
+
+    unsigned int bits = 0;
+
+    for ( unsigned digitplace = 0; digitplace < DIGITPLACE_COUNT; digitplace++ ) {
+        if ( lcd_layout_frame_word( digitplace ) == n ) {
+            bits |= glyph_bits( lcd_digit_segments[ digitplace ] , glyph_for( frame , digitplace ) );
+        }
     }
 
+    return bits;
+
 }
 
-void lcd_show_load_pin_animation(unsigned int step) {
 
-    switch( step ) {
+// Ready to launch squiggle. Even and odd places chase each other around the digit.
+
+constexpr glyph_segment_t squiggle_glyph( unsigned frame , unsigned digitplace ) {
+
+    static_assert( SQUIGGLE_SEGMENTS_SIZE == 8 , "SQUIGGLE_SEGMENTS_SIZE should be exactly 8 so we can use a logical AND to keep it in bounds" );
+
+    return ( digit_positions_rj( digitplace ) & 0x01 ) ? squiggle_segments[ ( ( SQUIGGLE_SEGMENTS_SIZE + 4 ) - frame ) & 0x07 ] : squiggle_segments[ frame ];
+
+}
+
+// "LoAd P" with a dash sliding right to point to the trigger pin
+
+constexpr glyph_segment_t load_pin_glyph( unsigned frame , unsigned digitplace ) {
+
+    return ( frame < LOAD_PIN_ANIMATION_FRAME_COUNT - 1 && digit_positions_rj( digitplace ) == 3 - frame ) ? glyph_dash : load_pin_message[ digitplace ];
+
+}
+
+constexpr auto squiggle_animation_struct = ConstexprArray< generate_lcd_animation_word< squiggle_glyph > , SQUIGGLE_ANIMATION_FRAME_COUNT * LCD_FRAME_WORD_COUNT >();
+constexpr auto load_pin_animation_struct = ConstexprArray< generate_lcd_animation_word< load_pin_glyph > , LOAD_PIN_ANIMATION_FRAME_COUNT * LCD_FRAME_WORD_COUNT >();
+
+const lcd_animation_t lcd_animation_squiggle = { (const lcd_frame_t *) squiggle_animation_struct.array , SQUIGGLE_ANIMATION_FRAME_COUNT };
+const lcd_animation_t lcd_animation_load_pin = { (const lcd_frame_t *) load_pin_animation_struct.array , LOAD_PIN_ANIMATION_FRAME_COUNT };
+
+// Show one frame of an animation. This is not on any hot path, so the divide does not matter.
+
+void lcd_show_animation_frame( const lcd_animation_t &animation , unsigned frame ) {
+
+    lcd_commit_frame( LCDMEM , animation.frames[ frame % animation.frame_count ] );
+
+}
+
+// Countdown page schedules. Without hardware page rotation, COUNTDOWN_MODE_ISR plays one of these tables one entry per tick.
+// We write them here as (page, ticks) steps and expand them at compile time into one entry per tick, where the first tick of a
+// step switches to its page and the rest are LCD_PAGE_HOLD. An LCD_PAGE_WRAP at the end takes the ISR back to the top.
+// A hold tick is the cheapest tick there is, so a long dwell costs nothing extra in the ISR.
+// Each schedule starts on the tick after the days page, since that is what resume_countdown_mode() puts up first.
+// Each handler sets the bank and LCDSON itself, so the steps can go in any order.
+
+struct lcd_page_step_t {
+    unsigned page;                      // LCD_PAGE_xxx
+    unsigned ticks;                     // How long to stay on it
+};
+
+// The usual rotation, a second on each page. The bank switch happens while blank to quench a visible flash.
+
+constexpr lcd_page_step_t lcd_page_steps_normal[] = {
+    { LCD_PAGE_HHMMSS , 1 },
+    { LCD_PAGE_BLANK  , 1 },
+    { LCD_PAGE_DAYS   , 1 },
+};
+
+// At least LCD_PAGE_SCHEDULE_LONG_DAYS left. Rest longer on the blank page, which lights nothing.
+
+constexpr lcd_page_step_t lcd_page_steps_long[] = {
+    { LCD_PAGE_HHMMSS , 1 },
+    { LCD_PAGE_BLANK  , 3 },
+    { LCD_PAGE_DAYS   , 1 },
+};
+
+// Less than a day left, so HHMMSS on every tick for increased excitement
+
+constexpr lcd_page_step_t lcd_page_steps_last_day[] = {
+    { LCD_PAGE_LAST_DAY , 1 },
+};
+
+template < const lcd_page_step_t *steps , unsigned count >
+constexpr unsigned lcd_page_steps_ticks( unsigned page ) {
+
+    unsigned ticks = 0;
+
+    for ( unsigned i = 0; i < count; i++ ) {
+        if ( page == LCD_PAGE_WRAP || steps[i].page == page ) {         // LCD_PAGE_WRAP counts every page
+            ticks += steps[i].ticks;
+        }
+    }
+
+    return ticks;
+}
+
+// The entry for the first tick of the first blank step, or 0 if there is none
+
+template < const lcd_page_step_t *steps , unsigned count >
+constexpr unsigned lcd_page_steps_blank_entry() {
+
+    unsigned entry = 0;
+
+    for ( unsigned i = 0; i < count; i++ ) {
+        if ( steps[i].page == LCD_PAGE_BLANK ) {
+            return entry;
+        }
+        entry += steps[i].ticks;
+    }
+
+    return 0;
+}
+
+template < const lcd_page_step_t *steps , unsigned count >
+constexpr unsigned int generate_lcd_page_schedule_entry( unsigned int entry ) {
+
+    for ( unsigned i = 0; i < count; i++ ) {
+
+        if ( entry < steps[i].ticks ) {
+            return ( entry == 0 ) ? steps[i].page : LCD_PAGE_HOLD;
+        }
+
+        entry -= steps[i].ticks;
+    }
+
+    return LCD_PAGE_WRAP;
+}
+
+#define LCD_PAGE_STEPS( steps ) steps , ( sizeof( steps ) / sizeof( steps[0] ) )
+
+constexpr auto lcd_page_schedule_normal_struct   = ConstexprArray< generate_lcd_page_schedule_entry< LCD_PAGE_STEPS( lcd_page_steps_normal   ) > , lcd_page_steps_ticks< LCD_PAGE_STEPS( lcd_page_steps_normal   ) >( LCD_PAGE_WRAP ) + 1 >();
+constexpr auto lcd_page_schedule_long_struct     = ConstexprArray< generate_lcd_page_schedule_entry< LCD_PAGE_STEPS( lcd_page_steps_long     ) > , lcd_page_steps_ticks< LCD_PAGE_STEPS( lcd_page_steps_long     ) >( LCD_PAGE_WRAP ) + 1 >();
+constexpr auto lcd_page_schedule_last_day_struct = ConstexprArray< generate_lcd_page_schedule_entry< LCD_PAGE_STEPS( lcd_page_steps_last_day ) > , lcd_page_steps_ticks< LCD_PAGE_STEPS( lcd_page_steps_last_day ) >( LCD_PAGE_WRAP ) + 1 >();
+
+static_assert( lcd_page_steps_ticks< LCD_PAGE_STEPS( lcd_page_steps_normal ) >( LCD_PAGE_WRAP ) > 0 && lcd_page_steps_ticks< LCD_PAGE_STEPS( lcd_page_steps_long ) >( LCD_PAGE_WRAP ) > 0 , "A page schedule with no ticks would spin the ISR on LCD_PAGE_WRAP forever" );
+
+#ifdef LCD_PAGE_STATS
+
+// The average lit segments on the HHMMSS page over a day, from the same tables the ISR shows
+
+constexpr unsigned lcd_table_lit_segments( const unsigned int *table , unsigned size ) {
+
+    unsigned count = 0;
+
+    for ( unsigned i = 0; i < size; i++ ) {
+        count += lcd_word_lit_segments( table[i] );
+    }
+
+    return count;
+}
+
+constexpr unsigned LCD_HHMMSS_LIT_SEGMENTS =
+        lcd_table_lit_segments( secs_countdown_lcd_word_struct.array  , COUNTDOWN_SECS_TABLE_SIZE  ) / COUNTDOWN_SECS_TABLE_SIZE +
+        lcd_table_lit_segments( mins_countdown_lcd_word_struct.array  , COUNTDOWN_MINS_TABLE_SIZE  ) / COUNTDOWN_MINS_TABLE_SIZE +
+        lcd_table_lit_segments( hours_countdown_lcd_word_struct.array , COUNTDOWN_HOURS_TABLE_SIZE ) / COUNTDOWN_HOURS_TABLE_SIZE;
+
+struct lcd_page_schedule_t {
+    const unsigned int *table;
+    unsigned blank_entry;               // Where to start with at_blank
+    unsigned ticks;                     // For one pass
+    unsigned hhmmss_ticks;
+    unsigned days_ticks;
+};
+
+#define LCD_PAGE_SCHEDULE( table_struct , steps ) {                         \
+        table_struct.array ,                                                \
+        lcd_page_steps_blank_entry< LCD_PAGE_STEPS( steps ) >() ,           \
+        lcd_page_steps_ticks< LCD_PAGE_STEPS( steps ) >( LCD_PAGE_WRAP ) ,  \
+        lcd_page_steps_ticks< LCD_PAGE_STEPS( steps ) >( LCD_PAGE_HHMMSS ) + lcd_page_steps_ticks< LCD_PAGE_STEPS( steps ) >( LCD_PAGE_LAST_DAY ) , \
+        lcd_page_steps_ticks< LCD_PAGE_STEPS( steps ) >( LCD_PAGE_DAYS )    \
+}
+
+#else
+
+struct lcd_page_schedule_t {
+    const unsigned int *table;
+    unsigned blank_entry;               // Where to start with at_blank
+};
+
+#define LCD_PAGE_SCHEDULE( table_struct , steps ) {                         \
+        table_struct.array ,                                                \
+        lcd_page_steps_blank_entry< LCD_PAGE_STEPS( steps ) >()             \
+}
 
-        case 0:
-            lcd_show_f(  3 , glyph_dash );
-            break;
+#endif
 
-        case 1:
-            lcd_show_f(  3 , glyph_SPACE );
-            lcd_show_f(  2 , glyph_dash );
-            break;
+constexpr lcd_page_schedule_t lcd_page_schedule_normal   = LCD_PAGE_SCHEDULE( lcd_page_schedule_normal_struct   , lcd_page_steps_normal   );
+constexpr lcd_page_schedule_t lcd_page_schedule_long     = LCD_PAGE_SCHEDULE( lcd_page_schedule_long_struct     , lcd_page_steps_long     );
+constexpr lcd_page_schedule_t lcd_page_schedule_last_day = LCD_PAGE_SCHEDULE( lcd_page_schedule_last_day_struct , lcd_page_steps_last_day );
 
-        case 2:
-            lcd_show_f(  2 , glyph_SPACE );
-            lcd_show_f(  1 , glyph_dash );
-            break;
+// COUNTDOWN_MODE_ISR picks these up (see lcd_display_exp.h)
 
-        case 3:
-            lcd_show_f(  1 , glyph_SPACE );
-            lcd_show_f(  0 , glyph_dash );
-            break;
+#pragma RETAIN
+const unsigned int *lcd_page_schedule;
+#pragma RETAIN
+const unsigned int *lcd_page_schedule_next;
+
+#ifdef LCD_PAGE_STATS
+
+unsigned lcd_page_segment_ticks;
+unsigned lcd_page_ticks;
 
-        case 4:
-            lcd_show_f(  0 , glyph_SPACE );
-            break;
+#endif
 
-        default:
-            __never_executed();
+void lcd_select_page_schedule( const unsigned days , const bool at_blank ) {
 
+    const lcd_page_schedule_t *s;
+
+    if ( days == 0 ) {
+        s = &lcd_page_schedule_last_day;
+    } else if ( days >= LCD_PAGE_SCHEDULE_LONG_DAYS ) {
+        s = &lcd_page_schedule_long;
+    } else {
+        s = &lcd_page_schedule_normal;
     }
 
+    lcd_page_schedule      = s->table;
+    lcd_page_schedule_next = s->table + ( at_blank ? s->blank_entry : 0 );
+
+    #ifdef LCD_PAGE_STATS
+        // Once a day at most, so the multiplies do not matter
+        lcd_page_segment_ticks = ( s->hhmmss_ticks * LCD_HHMMSS_LIT_SEGMENTS ) + ( s->days_ticks * lcd_frame_lit_segments( days_frame( days_lcdbmem_bcd ) ) );
+        lcd_page_ticks         = s->ticks;
+    #endif
+
+}
+
+
+void lcd_show_load_pin_animation(unsigned int step) {
+
+    lcd_show_animation_frame( lcd_animation_load_pin , step );
+
+}
+
+// Show a frame n the ready-to-lanuch squiggle animation
+// 0 <= step < SQUIGGLE_ANIMATION_FRAME_COUNT
+
+void lcd_show_squiggle_frame( byte step ) {
+
+    lcd_show_animation_frame( lcd_animation_squiggle , step );
+
 }
 
 
@@ -1036,12 +1880,12 @@ constexpr glyph_segment_t open_message[] = {
                                                    glyph_SPACE,
 };
 
+constexpr lcd_frame_t open_frame = lcd_frame( open_message );
+
 // Show " OPEn"
 void lcd_show_open_message() {
 
-    for( byte i=0; i<DIGITPLACE_COUNT; i++ ) {
-        lcd_show_f(  i , open_message[ DIGITPLACE_COUNT - 1- i] );        // digit place 12 is rightmost, so reverse order for text
-    }
+    lcd_show_frame( open_frame );
 }
 
 
@@ -1056,12 +1900,12 @@ constexpr glyph_segment_t start_message[] = {
                                                    glyph_rbrac
 };
 
+constexpr lcd_frame_t start_frame = lcd_frame( start_message );
+
 // Show "First Start"
 void lcd_show_start_message() {
 
-    for( byte i=0; i<DIGITPLACE_COUNT; i++ ) {
-        lcd_show_f(  i , start_message[ DIGITPLACE_COUNT - 1- i] );        // digit place 12 is rightmost, so reverse order for text
-    }
+    lcd_show_frame( start_frame );
 }
 
 constexpr glyph_segment_t  hold_message[] = {
@@ -1073,12 +1917,12 @@ constexpr glyph_segment_t  hold_message[] = {
                                                    glyph_5
 };
 
+constexpr lcd_frame_t hold_frame = lcd_frame( hold_message );
+
 // Show "First Start"
 void lcd_show_hold_message() {
 
-    for( byte i=0; i<DIGITPLACE_COUNT; i++ ) {
-        lcd_show_f(  i , hold_message[ DIGITPLACE_COUNT - 1- i] );        // digit place 12 is rightmost, so reverse order for text
-    }
+    lcd_show_frame( hold_frame );
 }
 
 
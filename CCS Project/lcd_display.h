@@ -9,6 +9,37 @@
 #define LCD_DISPLAY_H_
 
 #include "util.h"
+#include "lcd_layout.h"
+
+
+// *** LCD bias
+
+// If this is defined, the LCD will use an optional TPS7A voltage regulator attached to the bias pin.
+// If it is not defined, the we will configure the LCD to use the internal voltage reference.
+// Using the TPS7A reduces LCD total power significantly (about 40%), at the cost of an extra part.
+// Note that if a TPS7A is connected to pin 33 and the internal reference is enabled, it will waste lots of power even if the TPS7A is not enabled.
+// This lives here rather than with the other options in tsl-calibre-msp.cpp since initLCD() needs to see it too.
+#define USE_TPS7A_LCD_BIAS
+
+// If this is defined (and we have the TPS7A) then we check Vcc every so often and switch the bias over to the internal
+// charge pump when the batteries get too low for the TPS7A to make 3V, and back again when they recover. The TPS7A is
+// much cheaper when it can regulate (see the README), but below 3V it just passes Vcc though and the display fades.
+// Leave it undefined if you would rather have the fading as a low battery warning.
+#define LCD_BIAS_AUTO_SWITCH
+
+// Switch to the charge pump below this and back to the TPS7A above this. The gap keeps us from flapping back and forth
+// on the noise, or on the battery bouncing back a bit when the load changes.
+#define LCD_BIAS_INTERNAL_BELOW_MV  2950
+#define LCD_BIAS_TPS7A_ABOVE_MV     3050
+
+// Select the internal reference and charge pump for the LCD bias rather than the external TPS7A on R33. Takes effect
+// right away if the LCD is on, and otherwise the next time initLCD() turns it on. Only writes LCDVCTL, so powering the
+// TPS7A up or down is up to the caller.
+void lcd_set_bias_internal( bool internal );
+
+// Pick the lowest LCD voltage (on the charge pump) and LCD clock that are still good at this temperature. The voltage
+// takes effect right away, and the clock on the next lcd_set_clock_from_vlo().
+void lcd_set_temperature( int celsius );
 
 
 // *** LCD layout
@@ -27,14 +58,64 @@
 const byte READY_TO_LAUNCH_LCD_FRAME_COUNT=8;                             // How many frames in the ready-to-launch mode animation
 
 
+// A whole screen of digits as the LCDMEM words that hold them, one for each word that has a digit in it (see lcd_layout.h).
+// On this glass the digits are wired in pairs that each live in one LCDMEM word, so word 0 is the hours, 1 the mins, and 2 the secs.
+// Note that a frame owns the whole word, so committing one also sets or clears the colon and decimal point.
+
+constexpr unsigned LCD_FRAME_WORD_COUNT = lcd_layout_word_count();
+
+// Define this to build for new glass (or a PCB reroute) where the HH, MM, and SS digit pairs do not each get an LCDMEM word
+// to themselves. Everything in C falls back to per-digit writes, but the asm countdown ISR can not, so it
+// will scramble the display. Good enough to check out the new glass in setting mode.
+//#define LCD_LAYOUT_BRINGUP
+
+struct lcd_frame_t {
+    unsigned int words[LCD_FRAME_WORD_COUNT];
+};
+
+// Define this to keep running totals of commits and words written in lcd_commit_count and lcd_commit_words_written
+//#define LCD_COMMIT_STATS
+
+// Draw a glyph into a frame. pos=0 is the rightmost digit.
+void lcd_frame_set_glyph( lcd_frame_t &frame , const uint8_t pos , const glyph_segment_t glyph );
+
+// Write a frame into LCDMEM or LCDBMEM, only touching the words that changed. Returns the number of words written.
+unsigned lcd_commit_frame( char *lcdmem_base , const lcd_frame_t &frame );
+
+// How many segments a word or a whole frame lights. The glass draws more current the more segments are lit ("555555" is about
+// 30% more than "111111", and blank is cheapest), so this is our rough measure of what a page costs to show.
+
+constexpr unsigned lcd_word_lit_segments( unsigned int w ) {
+
+    unsigned count = 0;
+
+    while ( w ) {
+        w &= w - 1;                 // Clear the lowest set bit
+        count++;
+    }
+
+    return count;
+}
+
+constexpr unsigned lcd_frame_lit_segments( const lcd_frame_t &frame ) {
+
+    unsigned count = 0;
+
+    for ( unsigned n = 0; n < LCD_FRAME_WORD_COUNT; n++ ) {
+        count += lcd_word_lit_segments( frame.words[n] );
+    }
+
+    return count;
+}
+
+
 void lcd_segment_set( char * lcdmem_base , lcd_segment_location_t seg  );
 
 void lcd_segment_set_to_lcdmem( lcd_segment_location_t seg  );
 
 void lcd_segment_clear_to_lcdmem( lcd_segment_location_t seg  );
 
-// General function to write a glyph onto the LCD. No constraints on how pins are connected, but inefficient.
-// Remember that means that different segments in the same digit could be at different LCDMEM locations!
+// General function to write a glyph onto the LCD. One BIC and one BIS into the LCDMEM word that holds the digitplace.
 
 void lcd_write_glyph_to_lcdmem( byte digitplace, glyph_segment_t glyph );
 
@@ -93,8 +174,42 @@ void lcd_show_load_pin_message();
 constexpr unsigned LOAD_PIN_ANIMATION_FRAME_COUNT = 5;      // Dash sliding to the right to point ot the trigger pin
 void lcd_show_load_pin_animation(unsigned int step);
 
-// The lance is 2 digitplaces wide so we need extra frames to show it coming onto and off of the screen
-constexpr unsigned LANCE_ANIMATION_FRAME_COUNT = DIGITPLACE_COUNT+3;          // There really should be a better way to do this.
+
+// An animation is a table of whole frames (see lcd_display.cpp)
+
+struct lcd_animation_t {
+    const lcd_frame_t *frames;
+    unsigned frame_count;
+};
+
+extern const lcd_animation_t lcd_animation_squiggle;
+extern const lcd_animation_t lcd_animation_load_pin;
+
+// Show one frame of an animation. Frames past the end wrap around to the start.
+void lcd_show_animation_frame( const lcd_animation_t &animation , unsigned frame );
+
+// With at least this many days left COUNTDOWN_MODE_ISR uses the long page schedule, which sits on the blank page for longer
+// (see lcd_display.cpp). Nobody needs to read the seconds that far out, and a blank page lights no segments at all.
+#define LCD_PAGE_SCHEDULE_LONG_DAYS 2
+
+// Pick the page schedule that COUNTDOWN_MODE_ISR plays for this many days left, and where it starts. With LCD_PAGE_STATS the
+// days page must already be painted since we count its lit segments. With at_blank we start on the blank page rather than at
+// the top (HHMMSS), so a new day count never replaces the old one without a blank in between. With 0 days left this is just
+// HHMMSS on every tick.
+void lcd_select_page_schedule( unsigned days , bool at_blank );
+
+// Define this to have lcd_select_page_schedule() keep the two counts below. Read them in the debugger.
+//#define LCD_PAGE_STATS
+
+#ifdef LCD_PAGE_STATS
+
+// Lit segment ticks and total ticks for one pass through the selected schedule, so (segment ticks / ticks) is the average number
+// of lit segments. Set by lcd_select_page_schedule() to compare schedules against what EnergyTrace says. The HHMMSS page is
+// counted at its average over a day.
+extern unsigned lcd_page_segment_ticks;
+extern unsigned lcd_page_ticks;
+
+#endif
 
 // Show "First Start"
 void lcd_show_start_message();
@@ -127,6 +242,16 @@ void lcd_off();
 
 
 
+// Paint HH:MM.SS into the main LCD buffer using the countdown tables
+void lcd_show_countdown_hhmmss( const unsigned hours , const unsigned mins , const unsigned secs );
+
+// Paint HH:MM into the main LCD buffer using the countdown tables, with the seconds digits blank
+void lcd_show_countdown_hhmm( const unsigned hours , const unsigned mins );
+
+// Clear the colon and decimal point that lcd_show_countdown_hhmmss() and the countdown ISR light up
+void lcd_clear_countdown_decorations();
+
+
 // Init the "d" in the days display in the secondary LCD buffer
 void lcd_show_day_label_lcdbmem();
 
@@ -136,16 +261,27 @@ void lcd_show_day_label_lcdbmem();
 
 void lcd_show_days_lcdbmem( const unsigned days );
 
+// Count the days in the secondary LCD buffer down by one, only rewriting the digit words that changed.
+// The page must have been painted by lcd_show_days_lcdbmem() first.
+
+void lcd_show_days_lcdbmem_decrement();
+
 
 // Init the LCD. Clears memory.
 void initLCD();
 
+// Set the LCD clock divider for the given VLO frequency (see measure_vlo_hz()). Returns false if vlo_hz is not believable.
+bool lcd_set_clock_from_vlo( unsigned vlo_hz );
+
 
 // Blank all LCD segments in hardware
 void lcd_off();
 // Unblank all LCD segments in hardware
 void lcd_on();
 
+// Turn off the LCD completely. Only initLCD() brings it back.
+void lcd_shutdown();
+
 
 // Show the main mem bank on LCD
 void lcd_show_LCDMEM_bank();
@@ -166,6 +302,9 @@ void lcd_blinking_mode_all();
 // Put the LCD into double page buffer mode where you can switch beteween LCDMEM and LCDBMEM
 void lcd_blinking_mode_doublebuffer();
 
+// Put the LCD into double page buffer mode where the hardware alternates between LCDMEM and LCDBMEM about once per second
+void lcd_blinking_mode_page_rotation();
+
 // Show " OPEn"
 void lcd_show_open_message();
 
@@ -12,9 +12,52 @@ extern const unsigned int * const secs_lcd_words;
 extern const unsigned int * const mins_lcd_words;
 extern const unsigned int * const hours_lcd_words;
 
+// These count down and are rotated so the rollover entry is last: secs and mins go 58,57,...,00,59 and hours go 22,21,...,00,23.
+// The mins and hours entries also light the decimal point and colon.
+#define COUNTDOWN_SECS_TABLE_SIZE   60
+#define COUNTDOWN_MINS_TABLE_SIZE   60
+#define COUNTDOWN_HOURS_TABLE_SIZE  24
+
+extern const unsigned int * const secs_countdown_lcd_words;
+extern const unsigned int * const mins_countdown_lcd_words;
+extern const unsigned int * const hours_countdown_lcd_words;
+
 // Write a value from that array into this word to update the two digits on the LCD display
 extern unsigned int *secs_lcdmemw;
 extern unsigned int *mins_lcdmemw;
 extern unsigned int *hours_lcdmemw;
 
+// The countdown page schedule that COUNTDOWN_MODE_ISR plays when there is no hardware page rotation. Each entry is one tick and
+// holds one of these codes, which are byte offsets into the jump table in COUNTDOWN_MODE_ISR, so keep the two in step.
+// Set these with lcd_select_page_schedule().
+#define LCD_PAGE_HOLD       0           // Keep showing whatever page is up
+#define LCD_PAGE_HHMMSS     2
+#define LCD_PAGE_BLANK      4
+#define LCD_PAGE_DAYS       6
+#define LCD_PAGE_LAST_DAY   8           // Stay on HHMMSS and do not move on. The last day schedule is just this.
+#define LCD_PAGE_WRAP       10          // Not a tick. Go back to the top of lcd_page_schedule and do that entry instead.
+
+extern const unsigned int *lcd_page_schedule;           // Read at each LCD_PAGE_WRAP, so a new schedule starts at the end of the current pass
+extern const unsigned int *lcd_page_schedule_next;      // Read by COUNTDOWN_MODE_BEGIN and after each countdown_next_day()
+
+// Same as the above pointers, but as byte offsets from the start of LCDMEM so the asm can use them as constants in absolute addressing.
+// These are checked against the pinout at compile time in lcd_display.cpp.
+#define SECS_LCDMEM_OFFSET   6
+#define MINS_LCDMEM_OFFSET   14
+#define HOURS_LCDMEM_OFFSET  16
+
+// Define this to have the LCD blink hardware alternate between the HHMMSS page (LCDMEM) and the days page (LCDBMEM) during a countdown
+// rather than having COUNTDOWN_MODE_ISR rotate the pages in software. The ISR then only writes the digits and resyncs the blink
+// divider at the top of each minute. Note there is no blank page in this mode since the hardware can only alternate between two banks.
+//#define COUNTDOWN_HARDWARE_PAGE_ROTATION
+
+// Blink prescaler for the hardware page rotation. Aims for about 1 sec per page with the LCD clocked from VLO/4.
+#define COUNTDOWN_PAGE_ROTATION_BLKPRE  LCDBLKPRE__256
+
+// Define this to only wake once a minute while there is more than an hour left in a countdown. We show HH:MM (with the
+// seconds digits blank) and let the LCD blink hardware alternate it with the days page. COUNTDOWN_MINUTE_ISR is driven by
+// the RV3032 periodic minute update on ~INT, and hands off to the normal 1Hz COUNTDOWN_MODE_ISR for the final hour.
+// Note this changes what the countdown looks like (no seconds and no blank page until the final hour), so it is off for now.
+//#define COUNTDOWN_MINUTE_CADENCE
+
 #endif /* LCD_DISPLAY_EXP_H_ */
@@ -0,0 +1,149 @@
+/*
+ * lcd_layout.h
+ *
+ * Compile time facts about where the digits on this glass land in LCDMEM, worked out from define_lcd_pinout.h and
+ * define_lcd_to_msp430_connections.h. The fast paths (one word store for a two digit number) only work because we routed
+ * the PCB so each pair of digits lives alone in one LCDMEM word. Rather than assuming that, the C code asks here and falls
+ * back to masking each digit into its own word for any pair that is not wired that way, so a new glass or a reroute
+ * still builds and just runs a bit slower.
+ *
+ * Include the define_* headers first.
+ */
+
+#ifndef LCD_LAYOUT_H_
+#define LCD_LAYOUT_H_
+
+#include "util.h"
+
+
+// The LCDMEMW word that holds a single segment
+
+constexpr word lcd_layout_segment_word( lcd_segment_location_t seg ) {
+    return LCDMEMW_OFFSET_FOR_LPIN( lcdpin_to_lpin[ seg.lcd_pin ] );
+}
+
+// The LCDMEMW word that holds a digitplace. Each digitplace must be entirely in one word (checked in lcd_display.cpp),
+// so any segment will do.
+
+constexpr word lcd_layout_digit_word( unsigned digitplace ) {
+    return lcd_layout_segment_word( lcd_digit_segments[ digitplace ].SEG_A );
+}
+
+// How many digitplaces live in the given word
+
+constexpr unsigned lcd_layout_digits_in_word( word w ) {
+
+    unsigned count = 0;
+
+    for ( unsigned digitplace = 0; digitplace < DIGITPLACE_COUNT; digitplace++ ) {
+        if ( lcd_layout_digit_word( digitplace ) == w ) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+// True if this is the lowest digitplace in its word. Used to number the words in digitplace order.
+
+constexpr bool lcd_layout_first_in_word( unsigned digitplace ) {
+
+    for ( unsigned earlier = 0; earlier < digitplace; earlier++ ) {
+        if ( lcd_layout_digit_word( earlier ) == lcd_layout_digit_word( digitplace ) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Number of LCDMEM words that have digits in them. This is how many words a frame needs (see lcd_frame_t).
+
+constexpr unsigned lcd_layout_word_count() {
+
+    unsigned count = 0;
+
+    for ( unsigned digitplace = 0; digitplace < DIGITPLACE_COUNT; digitplace++ ) {
+        if ( lcd_layout_first_in_word( digitplace ) ) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+// Which frame word holds a digitplace. Frame words are numbered in the order their first digitplace appears.
+
+constexpr unsigned lcd_layout_frame_word( unsigned digitplace ) {
+
+    unsigned n = 0;
+
+    for ( unsigned earlier = 0; earlier < digitplace; earlier++ ) {
+        if ( lcd_layout_first_in_word( earlier ) ) {
+            if ( lcd_layout_digit_word( earlier ) == lcd_layout_digit_word( digitplace ) ) {
+                return n;
+            }
+            n++;
+        }
+    }
+
+    return n;           // First in its own word
+}
+
+// The LCDMEMW word for frame word n
+
+constexpr word lcd_layout_word_offset( unsigned n ) {
+
+    for ( unsigned digitplace = 0; digitplace < DIGITPLACE_COUNT; digitplace++ ) {
+        if ( lcd_layout_first_in_word( digitplace ) ) {
+            if ( n == 0 ) {
+                return lcd_layout_digit_word( digitplace );
+            }
+            n--;
+        }
+    }
+
+    return 0;           // No such word
+}
+
+// Which frame word holds a segment that is not part of a digit, like the colon. Returns lcd_layout_word_count() if the
+// segment is in a word with no digits, since then no frame word can hold it.
+
+constexpr unsigned lcd_layout_segment_frame_word( lcd_segment_location_t seg ) {
+
+    for ( unsigned n = 0; n < lcd_layout_word_count(); n++ ) {
+        if ( lcd_layout_word_offset( n ) == lcd_layout_segment_word( seg ) ) {
+            return n;
+        }
+    }
+
+    return lcd_layout_word_count();
+}
+
+// A pair gets the fast path if both digits are in the same word and nothing else with a digit in it shares that word,
+// so a precomputed word can be stored over the whole thing.
+
+constexpr bool lcd_layout_pair_fast( unsigned tens_digitplace , unsigned ones_digitplace ) {
+
+    return lcd_layout_digit_word( tens_digitplace ) == lcd_layout_digit_word( ones_digitplace ) &&
+           lcd_layout_digits_in_word( lcd_layout_digit_word( ones_digitplace ) ) == 2;
+
+}
+
+// Which of the HH:MM.SS pairs got the fast path, as a bitmask. Also kept in lcd_layout_fast_pair_mask in the image so you
+// can check a new layout in the debugger or the map file.
+
+constexpr unsigned LCD_LAYOUT_PAIR_HOURS = 0x01;
+constexpr unsigned LCD_LAYOUT_PAIR_MINS  = 0x02;
+constexpr unsigned LCD_LAYOUT_PAIR_SECS  = 0x04;
+constexpr unsigned LCD_LAYOUT_PAIRS_ALL  = LCD_LAYOUT_PAIR_HOURS | LCD_LAYOUT_PAIR_MINS | LCD_LAYOUT_PAIR_SECS;
+
+constexpr unsigned lcd_layout_fast_pairs() {
+
+    return ( lcd_layout_pair_fast( HOURS_TENS_DIGITPLACE , HOURS_ONES_DIGITPLACE ) ? LCD_LAYOUT_PAIR_HOURS : 0 ) |
+           ( lcd_layout_pair_fast( MINS_TENS_DIGITPLACE  , MINS_ONES_DIGITPLACE  ) ? LCD_LAYOUT_PAIR_MINS  : 0 ) |
+           ( lcd_layout_pair_fast( SECS_TENS_DIGITPLACE  , SECS_ONES_DIGITPLACE  ) ? LCD_LAYOUT_PAIR_SECS  : 0 );
+
+}
+
+#endif /* LCD_LAYOUT_H_ */
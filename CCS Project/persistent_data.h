@@ -0,0 +1,48 @@
+/*
+ * persistent_data.h
+ *
+ * The layout of the persistent data we keep in infoA FRAM. This is plain C so tsl_asm.asm can pull in the offsets with .cdecls.
+ * The static_asserts next to the definition of `persistent_data` in tsl-calibre-msp.cpp check the offsets against the structs.
+ */
+
+#ifndef PERSISTENT_DATA_H_
+#define PERSISTENT_DATA_H_
+
+// These two countdown vars keep track of how long until we unlock. We do not initialize them since they will get set when
+// we transition from setting mode to locked mode. They are in infoA FRAM so they will persist though resets and power cycles.
+// These are updated every minute while we are counting down in locked mode so in case we reset or lose power,
+// then we will come back up and restart where we left off. They are kept in FRAM which is persistent across power cycles,
+// and writing to these to update them only takes a single instruction.
+
+// It would be nice to keep these in a single unsigned long, but since the MSP430 only guarantees that writes to a single
+// unsigned int in FRAM are atomic, we store the two words separately so we can do very efficient writes to the low word
+// and only do ACID transaction writes when we need to update the high word (which is only once every 2^16 minutes ~= every 45 days)
+
+// We set backup_countdown_time_active_flag when we start an update and clear it when the update it complete.
+// When the backup_countdown_time_active_flag==true then use the backup_countdown_time, otherwise use countdown_time.
+
+// The value is the number of minutes left as of the most recent minute boundary, so it is the seconds left divided by 60 and
+// rounded up (see countdown_checkpoint_mins()). The countdown ISRs take a minute off right as the seconds left hit a whole minute.
+
+struct countdown_time_t {
+    unsigned int countdown_mins_h;
+    unsigned int countdown_mins_l;
+};
+
+
+// Collect up everything we want to have be persistent here to keep it organized.
+// We depend on these being initialized to 0 at the factory.
+struct persistant_data_t {
+
+    struct countdown_time_t countdown_time;
+    struct countdown_time_t backup_countdown_time;
+    unsigned backup_countdown_time_active_flag;
+
+};
+
+// Byte offsets into persistent_data for the asm
+#define PERSISTENT_COUNTDOWN_MINS_H_OFFSET  0
+#define PERSISTENT_COUNTDOWN_MINS_L_OFFSET  2
+#define PERSISTENT_ACTIVE_FLAG_OFFSET       8
+
+#endif /* PERSISTENT_DATA_H_ */
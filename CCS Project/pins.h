@@ -46,6 +46,8 @@
 #define RV3032_INT_PIV    P1IV          // Interrupt vector (read this to get which pin caused interrupt, reading clears highest pending)
 #define RV3032_INT_PIFG   P1IFG         // Interrupt flag (bit 1 for each pin that interrupted)
 #define RV3032_INT_PIES   P1IES         // Interrupt Edge Select (0=low-to-high 1=high-to-low)
+#define RV3032_INT_VECTOR PORT1_VECTOR  // ISR vector (shared with the switches)
+#define RV3032_INT_VECTOR_RAM ram_vector_PORT1  // RAM ISR vector (see ram_isrs.h)
 
 #define RV3032_INT_B (4)       // Bit
 
@@ -63,7 +65,8 @@
 #define RV3032_CLKOUT_PIV    P2IV          // Interrupt vector (read this to get which pin caused interrupt, reading clears highest pending)
 #define RV3032_CLKOUT_PIFG   P2IFG         // Interrupt flag (bit 1 for each pin that interrupted)
 #define RV3032_CLKOUT_PIES   P2IES         // Interrupt Edge Select (0=low-to-high 1=high-to-low)
-#define RV3032_CLKOUT_VECTOR PORT2_VECTOR  // ISR vector
+#define RV3032_CLKOUT_VECTOR PORT2_VECTOR  // ISR vector. Not in the FRAM table, only reached through the RAM vector below.
+#define RV3032_CLKOUT_VECTOR_RAM ram_vector_PORT2  // RAM ISR vector (see ram_isrs.h)
 
 #define RV3032_CLKOUT_B (0)       // Bit
 
@@ -159,6 +162,7 @@
 #define SWITCH_MOVE_PIFG   P1IFG          // Interrupt flag (bit 1 for each pin that interrupted)
 #define SWITCH_MOVE_PIES   P1IES          // Interrupt Edge Select (0=low-to-high 1=high-to-low)
 #define SWITCH_MOVE_VECTOR PORT1_VECTOR   // ISR vector
+#define SWITCH_MOVE_VECTOR_RAM ram_vector_PORT1   // RAM ISR vector (see ram_isrs.h)
 #define SWITCH_MOVE_B (7)
 
 #define SWITCH_CHANGE_PREN   P1REN
@@ -170,6 +174,7 @@
 #define SWITCH_CHANGE_PIFG   P1IFG          // Interrupt flag (bit 1 for each pin that interrupted)
 #define SWITCH_CHANGE_PIES   P1IES          // Interrupt Edge Select (0=low-to-high 1=high-to-low)
 #define SWITCH_CHANGE_VECTOR PORT1_VECTOR   // ISR vector
+#define SWITCH_CHANGE_VECTOR_RAM ram_vector_PORT1   // RAM ISR vector (see ram_isrs.h)
 #define SWITCH_CHANGE_B (6)
 
 // --- LOCKING TRIGGER SWITCH
@@ -183,6 +188,7 @@
 #define SWITCH_TRIGGER_PIFG   P1IFG          // Interrupt flag (bit 1 for each pin that interrupted)
 #define SWITCH_TRIGGER_PIES   P1IES          // Interrupt Edge Select (0=low-to-high 1=high-to-low)
 #define SWITCH_TRIGGER_VECTOR PORT1_VECTOR   // ISR vector
+#define SWITCH_TRIGGER_VECTOR_RAM ram_vector_PORT1   // RAM ISR vector (see ram_isrs.h)
 
 #define SWITCH_TRIGGER_B (1)
 
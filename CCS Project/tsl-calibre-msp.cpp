@@ -1,4 +1,5 @@
 #include <msp430.h>
+#include <stddef.h>         // offsetof
 
 #include "util.h"
 #include "pins.h"
@@ -10,6 +11,9 @@
 
 #include "tsl_asm.h"
 
+#include "persistent_data.h"
+#include "bcd_time.h"
+
 #include "define_lcd_pinout.h"
 #include "define_lcd_to_msp430_connections.h"
 #include "define_msp430_lcd_device.h"
@@ -29,6 +33,32 @@
 #define RV3032_DAYS_REG  0x05
 #define RV3032_MONS_REG  0x06
 #define RV3032_YEARS_REG 0x07
+#define RV3032_ALARM_MINS_REG  0x08
+#define RV3032_ALARM_HOURS_REG 0x09
+#define RV3032_ALARM_DATE_REG  0x0A
+#define RV3032_STATUS_REG      0x0D
+#define RV3032_TEMP_LSB_REG    0x0E     // Status flags in the bottom nibble
+#define RV3032_TEMP_MSB_REG    0x0F     // Whole degrees C, signed. The fraction is in the top of the register before it.
+#define RV3032_CONTROL1_REG    0x10
+#define RV3032_CONTROL2_REG    0x11
+#define RV3032_PMU_REG         0xC0     // The PMU through CLKOUT2 registers are mirrors of the RTC's EEPROM (see rv3032_shadow)
+#define RV3032_CLKOUT2_REG     0xC3
+
+#define RV3032_STATUS_VLF_B    (0)      // Voltage low flag. The RTC data may be bad.
+#define RV3032_STATUS_PORF_B   (1)      // Power on reset flag. The RTC data is bad.
+#define RV3032_ALARM_AE_B      (7)      // Top bit of each alarm register. 0=this field takes part in the alarm match.
+#define RV3032_STATUS_AF_B     (3)      // Alarm flag. Holds ~INT low until we clear it (when AIE is set).
+#define RV3032_CONTROL2_AIE_B  (3)      // Alarm interrupt enable
+#define RV3032_CONTROL2_UIE_B  (5)      // Periodic time update interrupt enable
+#define RV3032_PMU_NCLKE_B     (6)      // 1=CLKOUT pin off
+#define RV3032_TEMP_LSB_EEBUSY_B (2)    // EEPROM busy, including the refresh into the mirror registers at power up
+
+// The configuration that rv3032_init() sets up
+
+#define RV3032_CONTROL1_CONFIG 0b00010100   // USEL=1 so the periodic time update (when enabled) is once a minute, TE=0 so no periodic timer interrupt, EERD=1 to disable automatic EEPROM refresh (why would you want that?).
+#define RV3032_CLKOUT2_CONFIG  0b01100000   // CLKOUT XTAL low freq mode, freq=1Hz
+#define RV3032_PMU_CLKOUT_ON   0b00000000   // CLKOUT on, backup switchover disabled, no charge pump, 1K OHM trickle resistor, trickle charge off.
+#define RV3032_PMU_CLKOUT_OFF  0b01000000   // Same but CLKOUT off
 
 // Used to time how long ISRs take with an oscilloscope
 
@@ -43,11 +73,12 @@
 #define DEBUG_PULSE_OFF()    {}
 
 
-// If this is defined, the LCD will use an optional TPS7A voltage regulator attached to the bias pin.
-// If it is not defined, the we will configure the LCD to use the internal voltage reference.
-// Using the TPS7A reduces LCD total power significantly (about 40%), at the cost of an extra part.
-// Note that if a TPS7A is connected to pin 33 and the internal reference is enabled, it will waste lots of power even if the TPS7A is not enabled.
-#define USE_TPS7A_LCD_BIAS
+// Countdowns with more than this many days left go dormant at each day edge rather than waking us every second to update a display
+// that nobody is looking at. While dormant the LCD is off and the RV3032 alarm wakes us once a day at (RTC) midnight.
+// Once we are down to this many days we stay live so the display is up for the home stretch.
+#define COUNTDOWN_DORMANT_DAYS 7
+
+#define MINS_PER_DAY (24UL*60UL)
 
 
 
@@ -65,6 +96,19 @@ void depower_rv3032() {
 
 }
 
+// Goes into LPM4.5 with whatever pin interrupts the caller left enabled. Any of those will wake us with a reset and
+// SYSRSTIV will read SYSRSTIV_LPM5WU. There are no clocks in LPM4.5 so the LCD must already be off.
+#pragma FUNC_NEVER_RETURNS
+void sleep_until_pin_wakeup(){
+
+    // These lines enable the LPMx.5 modes
+    PMMCTL0_H = PMMPW_H;                    // Open PMM Registers for write
+    PMMCTL0_L |= PMMREGOFF_L;               // and set PMMREGOFF
+
+    __bis_SR_register(LPM4_bits);           // Enter LPM4.5. Clearing GIE does not prevent wakeup from LPMx.5.
+
+}
+
 // Goes into LPM3.5 to save power since we can never wake from here.
 // In LPMx.0 draws 1.38uA with the "First STart" message.
 // In LPMx.5 draws 1.13uA with the "First STart" message.
@@ -233,31 +277,72 @@ inline void initGPIO() {
 
 }
 
-// Low voltage flag indicates that the RTC has been re-powered and potentially lost its data.
+// RAM shadow of the RV3032 configuration registers, so we only send the ones that need to change.
+// They live in two blocks (CONTROL1-CONTROL2 and PMU-CLKOUT2) and rv3032_load_shadow() fills each with one burst read.
+// A byte is only trusted once we have read or written it since our last reset, since the RTC can get changed or reset
+// while we are not looking. Nothing ever sends EECMD, so writes to the EEPROM mirrored block only ever land in the
+// mirror RAM and the EEPROM keeps the factory defaults that the RTC reloads at power up.
 
-// Initialize RV3032 for the first time
-// Clears the low voltage flag
-// sets clkout to 1Hz
-// Disables backup function
-// Does not enable any interrupts
+#define RV3032_SHADOW_CONTROL_COUNT 2       // CONTROL1, CONTROL2
+#define RV3032_SHADOW_EEPROM_COUNT  4       // PMU, OFFSET, CLKOUT1, CLKOUT2. We never set OFFSET or CLKOUT1, but reading them keeps the burst in one piece.
+#define RV3032_SHADOW_COUNT         ( RV3032_SHADOW_CONTROL_COUNT + RV3032_SHADOW_EEPROM_COUNT )
+#define RV3032_SHADOW_ALL           ( ( 1U << RV3032_SHADOW_COUNT ) - 1 )
 
-void rv3032_init() {
+static uint8_t rv3032_shadow[RV3032_SHADOW_COUNT];
+static unsigned rv3032_shadow_known;        // One bit per rv3032_shadow byte. Starts out 0 at every reset.
 
-    // Give the RV3230 a chance to wake up before we start pounding it.
-    // POR refresh time(1) At power up ~66ms
-    // Also there is Tdeb which is the time it takes to recover from a backup switch over back to Vcc. It is unclear if this is 1ms or 1000ms so lets be safe.
-    __delay_cycles(1100000);    // 1 sec +/-10% (we are running at 1Mhz)
+constexpr bool rv3032_shadowed( uint8_t reg ) {
+    return ( reg >= RV3032_CONTROL1_REG && reg < RV3032_CONTROL1_REG + RV3032_SHADOW_CONTROL_COUNT ) ||
+           ( reg >= RV3032_PMU_REG      && reg < RV3032_PMU_REG      + RV3032_SHADOW_EEPROM_COUNT  );
+}
 
-    // Initialize our i2c pins as pull-up
-    i2c_init();
+constexpr unsigned rv3032_shadow_index( uint8_t reg ) {
+    return reg < RV3032_PMU_REG ? reg - RV3032_CONTROL1_REG : RV3032_SHADOW_CONTROL_COUNT + ( reg - RV3032_PMU_REG );
+}
+
+// Fill the whole shadow from the RTC
+
+void rv3032_load_shadow( i2c_session_t &rtc ) {
+
+    rtc.read( RV3032_CONTROL1_REG , &rv3032_shadow[ rv3032_shadow_index( RV3032_CONTROL1_REG ) ] , RV3032_SHADOW_CONTROL_COUNT );
+    rtc.read( RV3032_PMU_REG      , &rv3032_shadow[ rv3032_shadow_index( RV3032_PMU_REG      ) ] , RV3032_SHADOW_EEPROM_COUNT  );
+    rtc.run();
+
+    rv3032_shadow_known = RV3032_SHADOW_ALL;
+}
+
+// Write a configuration register unless the shadow says it already holds this value
+
+template <uint8_t reg>
+void rv3032_write_config( i2c_session_t &rtc , uint8_t value ) {
+
+    static_assert( rv3032_shadowed( reg ) , "Only the registers in rv3032_shadow can go through rv3032_write_config()" );
 
+    constexpr unsigned n = rv3032_shadow_index( reg );
+
+    if ( TBI( rv3032_shadow_known , n ) && rv3032_shadow[n] == value ) {
+        return;
+    }
+
+    rtc.write( reg , value );
+
+    rv3032_shadow[n] = value;
+    SBI( rv3032_shadow_known , n );
+}
+
+// Bring the configuration registers to what rv3032_init() wants, only writing the ones that are off.
+// CONTROL1 goes first so EERD is set before we touch the EEPROM mirror. Otherwise an automatic refresh from the EEPROM
+// could land on top of our writes.
+
+void rv3032_apply_config( i2c_session_t &rtc ) {
+
+    rv3032_write_config<RV3032_CONTROL1_REG>( rtc , RV3032_CONTROL1_CONFIG );
 
     // Set all the registers we care about that can get reset by either power-on-reset or recover from backup
     //uint8_t clkout2_reg = 0b00000000;        // CLKOUT XTAL low freq mode, freq=32768Hz
     //uint8_t clkout2_reg = 0b00100000;        // CLKOUT XTAL low freq mode, freq=1024Hz
-    uint8_t clkout2_reg = 0b01100000;        // CLKOUT XTAL low freq mode, freq=1Hz
 
-    i2c_write( RV_3032_I2C_ADDR , 0xc3 , &clkout2_reg , 1 );
+    rv3032_write_config<RV3032_CLKOUT2_REG>( rtc , RV3032_CLKOUT2_CONFIG );
 
     // First control reg. Note that turning off backup switch-over seems to save ~0.1uA
     //uint8_t pmu_reg = 0b01010000;          // CLKOUT off, Direct backup switching mode, no charge pump, 0.6K OHM trickle resistor, trickle charge Vbackup to Vdd. Only predicted to use 50nA more than disabled.
@@ -265,31 +350,131 @@ void rv3032_init() {
     //uint8_t pmu_reg = 0b01000000;         // CLKOUT off, Other disabled backup switching mode, no charge pump, trickle resistor off, trickle charge Vbackup to Vdd
     //uint8_t pmu_reg = 0b00011101;          // CLKOUT ON, Direct backup switching mode, no charge pump, 12K OHM trickle resistor, trickle charge Vbackup to Vdd.
     //uint8_t pmu_reg = 0b01000000;         // CLKOUT off, backup switchover disabled, no charge pump, 1K OHM trickle resistor, trickle charge off.
-    uint8_t pmu_reg = 0b00000000;         // CLKOUT on, backup switchover disabled, no charge pump, 1K OHM trickle resistor, trickle charge off.
-
 
     // TODO: which is lower power, INT or CLKOUT?
 
-    i2c_write( RV_3032_I2C_ADDR , 0xc0 , &pmu_reg , 1 );
+    rv3032_write_config<RV3032_PMU_REG>( rtc , RV3032_PMU_CLKOUT_ON );
+
+}
+
+// Reload the shadow from the RTC and check the parts of the configuration that only rv3032_init() ever sets. CONTROL2 and
+// the PMU CLKOUT bit come and go with the alarms and the minute interrupt, so they are not checked.
+// Returns a bitmask (by rv3032_shadow index) of the registers that do not hold what we expect, so 0 means all good.
+// Anything set here means the RTC lost its setup without losing time, like from an EEPROM refresh or a glitch on
+// the bus, and rv3032_apply_config() will put it back.
+
+unsigned rv3032_verify_config( i2c_session_t &rtc ) {
 
-    uint8_t control1_reg = 0b00000100;      // TE=0 so no periodic timer interrupt, EERD=1 to disable automatic EEPROM refresh (why would you want that?).
-    i2c_write( RV_3032_I2C_ADDR , 0x10 , &control1_reg , 1 );
+    rv3032_load_shadow( rtc );
 
-    i2c_shutdown();
+    unsigned bad = 0;
 
+    if ( rv3032_shadow[ rv3032_shadow_index( RV3032_CONTROL1_REG ) ] != RV3032_CONTROL1_CONFIG ) {
+        SBI( bad , rv3032_shadow_index( RV3032_CONTROL1_REG ) );
+    }
+
+    if ( rv3032_shadow[ rv3032_shadow_index( RV3032_CLKOUT2_REG ) ] != RV3032_CLKOUT2_CONFIG ) {
+        SBI( bad , rv3032_shadow_index( RV3032_CLKOUT2_REG ) );
+    }
+
+    if ( ( rv3032_shadow[ rv3032_shadow_index( RV3032_PMU_REG ) ] & ~_BV( RV3032_PMU_NCLKE_B ) ) != RV3032_PMU_CLKOUT_ON ) {
+        SBI( bad , rv3032_shadow_index( RV3032_PMU_REG ) );
+    }
+
+    return bad;
 }
 
-// Clear the low voltage flags. These flags remember if the chip has seen a voltage low enough to make it loose time.
+// Sleep in LPM3 for one watchdog interval off the VLO. wdtis is one of the WDTIS__xxx interval selects, counted in VLO clocks
+// (nominally 10KHz, but anywhere from 6KHz to 14KHz). Leaves GIE set.
 
-void rv3032_clear_LV_flags() {
+#pragma vector=WDT_VECTOR
+__interrupt void wdt_isr(void) {
+    __bic_SR_register_on_exit(LPM3_bits);
+}
+
+void sleep_vlo_interval( unsigned wdtis ) {
+
+    WDTCTL = WDTPW | WDTSSEL__VLO | WDTTMSEL | WDTCNTCL | wdtis;             // Interval timer mode off VLO
+    SFRIFG1 &= ~WDTIFG;
+    SFRIE1 |= WDTIE;
+
+    __bis_SR_register(LPM3_bits | GIE );
+
+    WDTCTL = WDTPW | WDTHOLD | WDTSSEL__VLO;        // Back the way main() left it
+    SFRIE1 &= ~WDTIE;
+}
+
+// Wait for the RV3032 to come up after we power it. It NAKs while it is still in backup mode (Tdeb) and sets EEbusy
+// while it loads its configuration from EEPROM (the ~66ms POR refresh), so we keep asking until it ACKs with EEbusy clear.
+// A NAKed read leaves the pulled up 0xff on the bus, which also reads as busy. We sleep in LPM3 between tries, so a cold
+// start only burns active current for the few hundred cycles each try takes, and an RTC that was already running is
+// ready on the first one.
+// Returns false if it is still not ready after RV3032_READY_TRIES, which is at least as long as the old one second busy wait.
+
+#define RV3032_READY_WDTIS  WDTIS__512      // 512 VLO clocks between tries, 37ms-85ms over the VLO range
+#define RV3032_READY_TRIES  31              // 31*512 clocks is 1.13 secs even with the VLO at 14KHz
+
+bool rv3032_wait_ready() {
+
+    for ( unsigned tries = 0; tries < RV3032_READY_TRIES; tries++ ) {
+
+        uint8_t temp_lsb_reg;
+
+        i2c_session_t rtc( RV_3032_I2C_ADDR );
+        rtc.read( RV3032_TEMP_LSB_REG , &temp_lsb_reg , 1 );
+
+        if ( !rtc.end() && !TBI( temp_lsb_reg , RV3032_TEMP_LSB_EEBUSY_B ) ) {
+            return true;
+        }
+
+        sleep_vlo_interval( RV3032_READY_WDTIS );
+    }
+
+    return false;
+}
+
+// Low voltage flag indicates that the RTC has been re-powered and potentially lost its data.
+
+// Initialize RV3032 for the first time
+// Clears the low voltage flag
+// sets clkout to 1Hz
+// Disables backup function
+// Does not enable any interrupts
+
+void rv3032_init() {
+
+    // Give the RV3230 a chance to wake up before we start pounding it.
+    // POR refresh time(1) At power up ~66ms
+    // Also there is Tdeb which is the time it takes to recover from a backup switch over back to Vcc. It is unclear if this is 1ms or 1000ms so lets be safe.
+    // If it never comes up we carry on anyway like we always have, and the status check after will catch it.
+    rv3032_wait_ready();
 
     // Initialize our i2c pins as pull-up
-    i2c_init();
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
+
+    // Two burst reads, then only the registers that are not already set. After a power up that is all three, but after
+    // a reset where the RTC kept running it is usually none of them.
+    rv3032_load_shadow( rtc );
+    rv3032_apply_config( rtc );
+
+    rtc.end();
+
+}
+
+// Clear the low voltage flags. These flags remember if the chip has seen a voltage low enough to make it loose time.
+
+void rv3032_clear_LV_flags( i2c_session_t &rtc ) {
 
     uint8_t status_reg=0x00;        // Set all flags to 0. Clears out the low voltage flag so if it is later set then we know that the chip lost power.
-    i2c_write( RV_3032_I2C_ADDR , 0x0d , &status_reg , 1 );
+    rtc.write( RV3032_STATUS_REG , status_reg );
 
-    i2c_shutdown();
+}
+
+void rv3032_clear_LV_flags() {
+
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
+    rv3032_clear_LV_flags( rtc );
+    rtc.end();
 
 }
 
@@ -298,12 +483,11 @@ void rv3032_clear_LV_flags() {
 
 void rv3032_shutdown() {
 
-    i2c_init();
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
 
-    uint8_t pmu_reg = 0b01000000;         // CLKOUT off, backup switchover disabled, no charge pump
-    i2c_write( RV_3032_I2C_ADDR , 0xc0 , &pmu_reg , 1 );
+    rv3032_write_config<RV3032_PMU_REG>( rtc , RV3032_PMU_CLKOUT_OFF );
 
-    i2c_shutdown();
+    rtc.end();
 
 }
 
@@ -311,22 +495,196 @@ void rv3032_shutdown() {
 // This will reset the prescaller in the RTC so that the next tick will come 1000ms from now.
 
 void rv3032_zero() {
-    // Initialize our i2c pins as pull-up
-    i2c_init();
 
-    unsigned char zero =0;
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
 
     // Then zero out the RTC to start counting over again, starting now. Note that writing any value to the seconds register resets the sub-second counters to the beginning of the second.
     // "Writing to the Seconds register creates an immediate positive edge on the LOW signal on CLKOUT pin."
-    i2c_write( RV_3032_I2C_ADDR , RV3032_SECS_REG  , &zero , sizeof( zero ) );
+    rtc.write( RV3032_SECS_REG , 0 );
+
+    rtc.end();
+}
+
+// Set the RTC time of day. Like rv3032_zero(), writing the seconds register resets the prescaler so the next tick comes 1000ms from now.
+
+void rv3032_set_tod( i2c_session_t &rtc , unsigned hours , unsigned mins , unsigned secs ) {
+
+    uint8_t tod_regs[3] = { bin_to_bcd( secs ) , bin_to_bcd( mins ) , bin_to_bcd( hours ) };
+
+    rtc.write( RV3032_SECS_REG , tod_regs , sizeof( tod_regs ) );     // Burst write secs, mins, hours
+}
+
+void rv3032_set_tod( unsigned hours , unsigned mins , unsigned secs ) {
+
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
+    rv3032_set_tod( rtc , hours , mins , secs );
+    rtc.end();
+}
+
+void rv3032_read_tod( unsigned &hours , unsigned &mins , unsigned &secs ) {
+
+    uint8_t tod_regs[3];
+
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
+    rtc.read( RV3032_SECS_REG , tod_regs , sizeof( tod_regs ) );      // Burst read secs, mins, hours. The RTC latches them all at the start of the read.
+    rtc.end();
+
+    secs  = bcd_to_bin( tod_regs[0] );
+    mins  = bcd_to_bin( tod_regs[1] );
+    hours = bcd_to_bin( tod_regs[2] );
+}
+
+// Whole degrees C from the RV3032's temperature sensor. It updates this by itself every second or so.
+
+int rv3032_read_temp_c() {
+
+    uint8_t temp_reg;
+
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
+    rtc.read( RV3032_TEMP_MSB_REG , &temp_reg , 1 );
+    rtc.end();
+
+    return (signed char) temp_reg;
+}
+
+// Set the alarm to pull ~INT low at the next midnight.
+// Turn off CLKOUT too unless asked not to, since nobody will be listening to it while we are dormant.
+
+void rv3032_arm_midnight_alarm( bool keep_clkout ) {
+
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
+
+    uint8_t alarm_regs[3] = { 0x00 , 0x00 , _BV( RV3032_ALARM_AE_B ) };        // Match mins=00 and hours=00, ignore the date
+    rtc.write( RV3032_ALARM_MINS_REG , alarm_regs , sizeof( alarm_regs ) );
+
+    // Make sure an old alarm is not still holding ~INT low, or we would never see the falling edge for this one
+    uint8_t status_reg;
+    rtc.read( RV3032_STATUS_REG , &status_reg , 1 );
+    rtc.run();
+    CBI( status_reg , RV3032_STATUS_AF_B );
+    rtc.write( RV3032_STATUS_REG , status_reg );
+
+    rv3032_write_config<RV3032_CONTROL2_REG>( rtc , _BV( RV3032_CONTROL2_AIE_B ) );        // Alarm interrupt on ~INT. Everything else off.
+
+    if ( !keep_clkout ) {
+        rv3032_write_config<RV3032_PMU_REG>( rtc , RV3032_PMU_CLKOUT_OFF );
+    }
 
-    i2c_shutdown();
+    rtc.end();
+}
+
+// Undo rv3032_arm_midnight_alarm() and get the 1Hz CLKOUT going again
+
+void rv3032_disarm_alarm( i2c_session_t &rtc ) {
+
+    rv3032_write_config<RV3032_CONTROL2_REG>( rtc , 0x00 );
+    rv3032_write_config<RV3032_PMU_REG>( rtc , RV3032_PMU_CLKOUT_ON );
+
+}
+
+void rv3032_disarm_alarm() {
+
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
+    rv3032_disarm_alarm( rtc );
+    rtc.end();
+}
+
+// Returns true if the RTC has kept good time since the last rv3032_clear_LV_flags().
+// Note that if the RTC is not powered up yet then the status reads as 0xff since the i2c lines are pulled up, so that shows as bad too.
+
+bool rv3032_time_valid( i2c_session_t &rtc ) {
+
+    uint8_t status_reg;
+    rtc.read( RV3032_STATUS_REG , &status_reg , 1 );
+    rtc.run();
+
+    return !TBI( status_reg , RV3032_STATUS_VLF_B ) && !TBI( status_reg , RV3032_STATUS_PORF_B );
+}
+
+// Pulse ~INT at the top of each minute (rv3032_init() sets USEL so the periodic time update is once a minute rather than once a second).
+// The datasheet has the RTC release ~INT by itself after tRTN (~7.8ms) for this interrupt, so we never need to clear UF and
+// COUNTDOWN_MINUTE_ISR can run without any I2C.
+
+void rv3032_enable_minute_interrupt() {
+
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
+
+    rv3032_write_config<RV3032_CONTROL2_REG>( rtc , _BV( RV3032_CONTROL2_UIE_B ) );        // Periodic time update on ~INT. Everything else off.
+
+    rtc.end();
+}
+
+void rv3032_disable_minute_interrupt() {
+
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
+
+    rv3032_write_config<RV3032_CONTROL2_REG>( rtc , 0x00 );
+
+    rtc.end();
+}
+
+// Returns true if the alarm has gone off. Also clears the alarm flag so ~INT is released and can fall again on the next alarm.
+// We only clear AF and leave the low voltage flags alone (see rv3032_clear_LV_flags()).
+
+bool rv3032_test_and_clear_alarm( i2c_session_t &rtc ) {
+
+    uint8_t status_reg;
+    rtc.read( RV3032_STATUS_REG , &status_reg , 1 );
+    rtc.run();
+
+    bool alarm = TBI( status_reg , RV3032_STATUS_AF_B );
+
+    if (alarm) {
+        CBI( status_reg , RV3032_STATUS_AF_B );
+        rtc.write( RV3032_STATUS_REG , status_reg );
+    }
+
+    return alarm;
+}
+
+bool rv3032_test_and_clear_alarm() {
+
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
+    const bool alarm = rv3032_test_and_clear_alarm( rtc );
+    rtc.end();
+
+    return alarm;
+}
+
+// Replace hh:mm:ss with (24:00:00 - hh:mm:ss) mod 24h.
+// We keep the RTC midnight lined up with the countdown day edges, so this converts between the HHMMSS left on the countdown
+// and the RTC time of day (in either direction).
+
+void hhmmss_complement( unsigned &hours , unsigned &mins , unsigned &secs ) {
+
+    if ( hours || mins || secs ) {
+
+        secs  = 60 - secs;
+        mins  = 59 - mins;
+        hours = 23 - hours;
+
+        if ( secs == 60 ) {
+            secs = 0;
+            mins++;
+        }
+
+        if ( mins == 60 ) {
+            mins = 0;
+            hours++;
+        }
+    }
 }
 
 // Shortcuts for setting the RAM vectors. Note we need the (void *) casts because the compiler won't let us make the vectors into `near __interrupt (* volatile vector)()` like it should.
+// Note that CLKOUT (PORT2) is RAM vector only. Nothing is in the FRAM table for it, so until main() has done ACTIVATE_RAM_ISRS()
+// a CLKOUT interrupt goes straight to the ISR trap. Do not enable it or sleep waiting on it before then.
 
 #define SET_CLKOUT_VECTOR(x) do {RV3032_CLKOUT_VECTOR_RAM = (void *) x;} while (0)
-#define SET_TRIGGER_VECTOR(x) do {TRIGGER_VECTOR_RAM = (void *) x;} while (0)
+#define SET_SWITCH_VECTOR(x) do {SWITCH_CHANGE_VECTOR_RAM = (void *) x;} while (0)      // All the switches share the PORT1 vector
+#define SET_RV3032_INT_VECTOR(x) do {RV3032_INT_VECTOR_RAM = (void *) x;} while (0)     // ...and so does ~INT, but we only use it when the switches are off
+#define SET_WDT_VECTOR(x) do {ram_vector_WDT = (void *) x;} while (0)                     // Only ever wdt_isr(), for sleep_vlo_interval()
+
+static_assert( RV3032_INT_B == 4 , "COUNTDOWN_MINUTE_ISR in tsl_asm.asm assumes ~INT is on BIT4" );
 
 // Terminate after one day
 bool testing_only_mode = false;
@@ -528,239 +886,548 @@ void unlock() {
 
     // Open each pair of solenoids in sequence, hopefully pulling them just long enough for the lock slide to retract.
 
-    unsigned pull_pair = next_starting_pair;
+    unsigned pull_pair = next_starting_pair;
+
+    do {
+
+        toggle_lock_group(pull_pair);
+        __delay_cycles( 100000 );           // Delay to slightly let the batteries recover
+
+        pull_pair++;
+        pull_pair %=3;
+
+    } while ( pull_pair != next_starting_pair);
+
+    next_starting_pair++;
+    next_starting_pair%=3;
+}
+
+// See persistent_data.h for the layout and how the countdown checkpoint works.
+
+// Tell compiler/linker to put this in "info memory" at 0x1800
+// This area of memory never gets overwritten, not by power cycle and not by downloading a new binary image into program FRAM.
+// We have to mark `volatile` so that the compiler will really go to the FRAM every time rather than optimizing out some accesses.
+// We depend on the programming process to clear this to zero so we can tell if we are starting from factory or restarting after reset or battery change.
+volatile persistant_data_t __attribute__(( __section__(".infoA") )) persistent_data;
+
+// The countdown ISRs update the checkpoint using these offsets
+static_assert( offsetof( persistant_data_t , countdown_time.countdown_mins_h ) == PERSISTENT_COUNTDOWN_MINS_H_OFFSET , "PERSISTENT_COUNTDOWN_MINS_H_OFFSET does not match persistant_data_t" );
+static_assert( offsetof( persistant_data_t , countdown_time.countdown_mins_l ) == PERSISTENT_COUNTDOWN_MINS_L_OFFSET , "PERSISTENT_COUNTDOWN_MINS_L_OFFSET does not match persistant_data_t" );
+static_assert( offsetof( persistant_data_t , backup_countdown_time_active_flag ) == PERSISTENT_ACTIVE_FLAG_OFFSET , "PERSISTENT_ACTIVE_FLAG_OFFSET does not match persistant_data_t" );
+
+// CD_CHECKPOINT in tsl_asm.asm writes SYSCFG0 the same way, so change both together.
+
+void unlock_persistant_data() {
+    SYSCFG0 = PFWP;                     // Write protect only program FRAM. Interestingly it appears that the password is not needed here?
+}
+
+void lock_persistant_data() {
+    SYSCFG0 = PFWP | DFWP;              // Write protect both program and data FRAM.
+}
+
+// Checkpoint the minutes left in the countdown.
+// The backup copy is complete the whole time the primary is being written, so a reset at any point leaves us one good copy.
+// The countdown ISRs only use this when the low word is about to borrow. Every other minute they just decrement the low word.
+
+void persist_countdown_mins( unsigned long mins ) {
+
+    unlock_persistant_data();
+
+    if ( !persistent_data.backup_countdown_time_active_flag ) {
+        // Only take a new backup if the primary is good. Otherwise the backup is already the last good copy.
+        persistent_data.backup_countdown_time.countdown_mins_h = persistent_data.countdown_time.countdown_mins_h;
+        persistent_data.backup_countdown_time.countdown_mins_l = persistent_data.countdown_time.countdown_mins_l;
+        persistent_data.backup_countdown_time_active_flag = 1;
+    }
+
+    persistent_data.countdown_time.countdown_mins_h = mins >> 16;
+    persistent_data.countdown_time.countdown_mins_l = (unsigned) mins;
+    persistent_data.backup_countdown_time_active_flag = 0;
+
+    lock_persistant_data();
+}
+
+// Also rolls back a checkpoint that was cut off by a reset, so the primary copy is good when we return. The countdown ISRs count on that.
+
+unsigned long recall_countdown_mins() {
+
+    if ( persistent_data.backup_countdown_time_active_flag ) {
+
+        unlock_persistant_data();
+
+        persistent_data.countdown_time.countdown_mins_h = persistent_data.backup_countdown_time.countdown_mins_h;
+        persistent_data.countdown_time.countdown_mins_l = persistent_data.backup_countdown_time.countdown_mins_l;
+        persistent_data.backup_countdown_time_active_flag = 0;
+
+        lock_persistant_data();
+    }
+
+    return ( ( (unsigned long) persistent_data.countdown_time.countdown_mins_h ) << 16 ) | persistent_data.countdown_time.countdown_mins_l;
+}
+
+// Called from the countdown ISRs at a minute boundary when the low word of the checkpoint is 0, so taking off one more minute
+// would borrow from the high word. That needs the full transaction.
+
+#pragma FUNC_EXT_CALLED
+void countdown_checkpoint_borrow() {
+
+    unsigned long mins = recall_countdown_mins();
+
+    if ( mins ) {           // At 0 we are about to unlock and countdown_unlock() takes care of the checkpoint.
+        persist_countdown_mins( mins - 1 );
+    }
+}
+
+
+// The checkpoint for this much time left. This is the rounding that persistent_data.h promises, so everything that writes a
+// checkpoint from a time goes through here.
+
+constexpr unsigned long countdown_checkpoint_mins( unsigned days , unsigned hours , unsigned mins , unsigned secs ) {
+    return ( days * MINS_PER_DAY ) + ( hours * MINS_PER_HOUR ) + mins + ( secs ? 1 : 0 );
+}
+
+// A model of what the countdown ISRs do to the checkpoint, which is take a minute off on the tick that shows :00. Steps a
+// countdown of a few minutes one tick at a time and checks that the checkpoint always matches countdown_checkpoint_mins().
+
+constexpr bool countdown_checkpoint_tracks( unsigned long secs_left ) {
+
+    unsigned long checkpoint = countdown_checkpoint_mins( 0 , 0 , secs_left / 60 , secs_left % 60 );
+
+    while ( secs_left ) {
+
+        secs_left--;
+
+        if ( secs_left % 60 == 0 ) {
+            checkpoint--;
+        }
+
+        if ( checkpoint != countdown_checkpoint_mins( 0 , 0 , secs_left / 60 , secs_left % 60 ) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// A start on a whole minute used to lose a minute, since the checkpoint came off on the roll to :59 instead.
+static_assert( countdown_checkpoint_tracks( 3 * 60 )      , "Checkpoint does not track a countdown that starts on a whole minute" );
+static_assert( countdown_checkpoint_tracks( 2 * 60 + 30 ) , "Checkpoint does not track a countdown that starts part way through a minute" );
+static_assert( countdown_checkpoint_tracks( 2 * 60 + 1 )  , "Checkpoint does not track a countdown that starts one second past a minute" );
+
+
+// Here are our actual working variables that stay in RAM
+// These all get initialized at the moment the device is locked, or
+// if we boot up and detect that we were already running.
+
+// These are displayed
+volatile unsigned int countdown_d,countdown_h,countdown_m,countdown_s;
+
+// These are for safekeeping in case we reset.
+// Note that these are redundant, but it is faster to keep them in this separate format
+
+countdown_time_t countdown_time;
+
+
+// Start calling the clkout vector above on each tick form the RTC, starting at next tick
+// note that you might want to call rc3032_zero() first to ensure a full second elapses before first tick.
+
+void enable_rv3032_clkout_interrupt() {
+    // Now we enable the interrupt on the RTC CLKOUT pin. For now on we must remember to
+    // disable it again if we are going to end up in sleepforever mode.
+
+    // Clear any pending interrupts from the RV3032 clkout pin and then enable interrupts for the next falling edge
+    // We we should not get a real one for 500ms so we have time to do our stuff
+
+    CBI( RV3032_CLKOUT_PIFG     , RV3032_CLKOUT_B    );
+    SBI( RV3032_CLKOUT_PIE      , RV3032_CLKOUT_B    );
+}
+
+
+void disable_rv3032_clkout_interrupt() {
+
+    CBI( RV3032_CLKOUT_PIE      , RV3032_CLKOUT_B    );
+    CBI( RV3032_CLKOUT_PIFG     , RV3032_CLKOUT_B    );
+
+}
+
+// Interrupt on the falling edge of the RV3032 ~INT pin. It is open collector so we pull it up while we are listening.
+
+void enable_rv3032_int_interrupt() {
+
+    CBI( RV3032_INT_PDIR , RV3032_INT_B );      // Input. Note that the pull select is already UP from initGPIO().
+    SBI( RV3032_INT_POUT , RV3032_INT_B );      // Pull-up
+    SBI( RV3032_INT_PIES , RV3032_INT_B );      // High-to-low
+
+    // Changing the pin could have set the flag
+    CBI( RV3032_INT_PIFG , RV3032_INT_B );
+    SBI( RV3032_INT_PIE , RV3032_INT_B );
+}
+
+// Back to driving low the way initGPIO() leaves it
+
+void disable_rv3032_int_interrupt() {
+
+    CBI( RV3032_INT_PIE , RV3032_INT_B );
+    CBI( RV3032_INT_POUT , RV3032_INT_B );
+    SBI( RV3032_INT_PDIR , RV3032_INT_B );
+    CBI( RV3032_INT_PIFG , RV3032_INT_B );
+}
+
+// Wakes capture_at_next_clkout_edge() on a CLKOUT rising edge and captures TA0R then. The capture is the software kind
+// (flipping the capture input between GND and VCC), but the delay from edge to capture is the same every time so it cancels out.
+
+static volatile unsigned clkout_edge_ticks;
+static volatile bool clkout_edge_seen;
+
+__interrupt void clkout_edge_capture_isr(void) {
+
+    TA0CCTL0 ^= CCIS0;                          // GND->VCC is a rising edge on the capture input...
+    while ( !( TA0CCTL0 & CCIFG ) );            // ...which SCS syncs to the next VLO clock
+    TA0CCTL0 &= ~( CCIFG | CCIS0 );             // Back to GND for next time
+
+    clkout_edge_ticks = TA0CCR0;
+    clkout_edge_seen = true;
+
+    CBI( RV3032_CLKOUT_PIFG , RV3032_CLKOUT_B );
+    __bic_SR_register_on_exit(LPM3_bits);
+}
+
+// Sleep in LPM3 until the next rising edge on CLKOUT and get TA0R then. Gives up after 2^15 VLO clocks (at least 2.3s).
+
+static bool capture_at_next_clkout_edge( unsigned &ticks ) {
+
+    clkout_edge_seen = false;
+
+    CBI( RV3032_CLKOUT_PIFG , RV3032_CLKOUT_B );
+    SBI( RV3032_CLKOUT_PIE , RV3032_CLKOUT_B );
+
+    sleep_vlo_interval( WDTIS__32K );           // Whichever comes first wakes us, the edge or the WDT
+
+    CBI( RV3032_CLKOUT_PIE , RV3032_CLKOUT_B );
+
+    ticks = clkout_edge_ticks;
+    return clkout_edge_seen;
+}
+
+// Measure the VLO against the RV3032 1Hz CLKOUT. We run Timer_A off the VLO (by way of ACLK) and capture it on two
+// rising edges one second apart, so the difference is the VLO frequency in Hz.
+// Sleeps in LPM3 for up to 3 ticks with the CLKOUT pin interrupt pointed at clkout_edge_capture_isr(), so only call this when
+// nothing is counting CLKOUT ticks (the countdown points the vector back at itself when it starts). This is fine to call from
+// an ISR, since we nest the CLKOUT and WDT interrupts and put GIE back the way we found it.
+// Returns 0 if CLKOUT is not ticking.
+
+unsigned measure_vlo_hz() {
+
+    const unsigned short sr = __get_SR_register();      // So we can put GIE back
+
+    const unsigned csctl4 = CSCTL4;
+    CSCTL4 = ( csctl4 & ~( SELA0 | SELA1 ) ) | SELA__VLOCLK;       // Nothing else uses ACLK
+
+    TA0CCTL0 = CM_1 | CCIS_2 | SCS | CAP;       // Capture on rising edge of GND (for now)
+    TA0CTL = TASSEL__ACLK | MC__CONTINUOUS | TACLR;
+
+    SET_CLKOUT_VECTOR( &clkout_edge_capture_isr );
+
+    unsigned start, end;
+    unsigned vlo_hz = 0;
+
+    // The first edge after CLKOUT comes back on (see rv3032_disarm_alarm()) can be short, so skip it.
+
+    if ( capture_at_next_clkout_edge( start ) && capture_at_next_clkout_edge( start ) && capture_at_next_clkout_edge( end ) ) {
+        vlo_hz = end - start;
+    }
+
+    if ( !( sr & GIE ) ) {
+        __disable_interrupt();
+    }
+
+    TA0CTL = MC__STOP | TACLR;
+    TA0CCTL0 = 0;
+    CSCTL4 = csctl4;
+
+    CBI( RV3032_CLKOUT_PIFG , RV3032_CLKOUT_B );
+
+    return vlo_hz;
+}
+
+// Measure this unit's VLO right now and pick the slowest LCD clock that will not flicker with it. The VLO drifts with
+// temperature so we redo this once a day. If the measurement goes wrong we just keep the divider we have.
+
+void calibrate_lcd_clock() {
+    lcd_set_clock_from_vlo( measure_vlo_hz() );
+}
+
+#if defined( USE_TPS7A_LCD_BIAS ) && defined( LCD_BIAS_AUTO_SWITCH )
+
+// We measure Vcc backwards by reading the internal 1.5V reference against Vcc, so a bigger Vcc gives a smaller reading.
+// That way we never have to divide at runtime - the thresholds get turned into ADC counts at compile time instead.
+
+#define VCC_REF_MV  1500UL
+#define VCC_ADC_MAX 1023UL          // 10 bit
+
+constexpr unsigned vcc_mv_to_adc( unsigned long mv ) {
+    return ( VCC_REF_MV * VCC_ADC_MAX ) / mv;
+}
+
+static_assert( vcc_mv_to_adc( LCD_BIAS_INTERNAL_BELOW_MV ) > vcc_mv_to_adc( LCD_BIAS_TPS7A_ABOVE_MV ) , "LCD_BIAS_INTERNAL_BELOW_MV should be below LCD_BIAS_TPS7A_ABOVE_MV" );
+
+// One conversion of the 1.5V reference with Vcc as the ADC reference. Everything goes back off afterwards, so this
+// only costs anything while it runs (a few hundred us at 1MHz).
+
+unsigned read_vcc_adc() {
+
+    PMMCTL0_H = PMMPW_H;                    // Open PMM Registers for write
+    PMMCTL2 |= INTREFEN;                    // Turn on the 1.5V reference so the ADC can see it
+    __delay_cycles( 400 );                  // Let it settle (we are running at 1Mhz)
+
+    ADCCTL0 = ADCSHT_8 | ADCON;             // Long sample time since the reference is a weak source
+    ADCCTL1 = ADCSHP;                       // Sample timer, MODCLK
+    ADCCTL2 = ADCRES;                       // 10 bit
+    ADCMCTL0 = ADCSREF_0 | ADCINCH_13;      // A13 is the 1.5V reference, measured against AVCC
 
-    do {
+    ADCCTL0 |= ADCENC | ADCSC;
+    while ( ADCCTL1 & ADCBUSY );
 
-        toggle_lock_group(pull_pair);
-        __delay_cycles( 100000 );           // Delay to slightly let the batteries recover
+    const unsigned adc = ADCMEM0;
 
-        pull_pair++;
-        pull_pair %=3;
+    ADCCTL0 &= ~ADCENC;                     // ADCON can only be cleared with ENC off
+    ADCCTL0 = 0;
 
-    } while ( pull_pair != next_starting_pair);
+    PMMCTL2 &= ~INTREFEN;
+    PMMCTL0_H = 0;                          // Lock PMM Registers
 
-    next_starting_pair++;
-    next_starting_pair%=3;
+    return adc;
 }
 
-// These two countdown vars keep track of how long until we unlock. We do not initialize them since they will get set when
-// we transition from setting mode to locked mode. They are in infoA FRAM so they will persist though resets and power cycles.
-// These are updated every minute while we are counting down in locked mode so in case we reset or lose power,
-// then we will come back up and restart where we left off. They are kept in FRAM which is persistent across power cycles,
-// and writing to these to update them only takes a single instruction.
-
-// It would be nice to keep these in a single unsigned long, but since the MSP430 only guarantees that writes to a single
-// unsigned int in FRAM are atomic, we store the two words separately so we can do very efficient writes to the low word
-// and only do ACID transaction writes when we need to update the high word (which is only once every 2^16 minutes ~= every 45 days)
+// Go with the TPS7A while the batteries can keep it regulating, otherwise with the charge pump.
+// We do this wherever we do calibrate_lcd_clock(), so about once a day. The batteries do not sag faster than that.
 
-// We set backup_countdown_time_active_flag when we start an update and clear it when the update it complete.
-// When the backup_countdown_time_active_flag==true then use the backup_countdown_time, otherwise use countdown_time.
+static bool lcd_bias_internal_now = false;      // The TPS7A is what initGPIO() and initLCD() start with after a reset
 
+void update_lcd_bias() {
 
-struct countdown_time_t {
-    unsigned int countdown_mins_h;
-    unsigned int countdown_mins_l;
-};
+    const unsigned adc = read_vcc_adc();
 
+    if ( !lcd_bias_internal_now && adc > vcc_mv_to_adc( LCD_BIAS_INTERNAL_BELOW_MV ) ) {
 
-// Collect up everything we want to have be persistent here to keep it organized.
-// We depend on these being initialized to 0 at the factory.
-struct persistant_data_t {
+        // Order matters - the internal reference must not be on while the TPS7A is driving R33, and vice versa
 
-    countdown_time_t countdown_time;
-    countdown_time_t backup_countdown_time;
-    unsigned backup_countdown_time_active_flag;
+        CBI( TSP_ENABLE_POUT , TSP_ENABLE_B );
+        CBI( TSP_IN_POUT , TSP_IN_B );
+        lcd_set_bias_internal( true );
+        lcd_bias_internal_now = true;
 
-};
+    } else if ( lcd_bias_internal_now && adc < vcc_mv_to_adc( LCD_BIAS_TPS7A_ABOVE_MV ) ) {
 
-// Tell compiler/linker to put this in "info memory" at 0x1800
-// This area of memory never gets overwritten, not by power cycle and not by downloading a new binary image into program FRAM.
-// We have to mark `volatile` so that the compiler will really go to the FRAM every time rather than optimizing out some accesses.
-// We depend on the programming process to clear this to zero so we can tell if we are starting from factory or restarting after reset or battery change.
-volatile persistant_data_t __attribute__(( __section__(".infoA") )) persistent_data;
+        lcd_set_bias_internal( false );
+        SBI( TSP_IN_POUT , TSP_IN_B );
+        SBI( TSP_ENABLE_POUT , TSP_ENABLE_B );
+        lcd_bias_internal_now = false;
 
-void unlock_persistant_data() {
-    SYSCFG0 = PFWP;                     // Write protect only program FRAM. Interestingly it appears that the password is not needed here?
+    }
 }
 
-void lock_persistant_data() {
-    SYSCFG0 = PFWP | DFWP;              // Write protect both program and data FRAM.
+#else
+
+void update_lcd_bias() {
 }
 
+#endif
 
-// Here are our actual working variables that stay in RAM
-// These all get initialized at the moment the device is locked, or
-// if we boot up and detect that we were already running.
+// Retune the LCD for the current temperature, VLO and batteries. Temperature goes first since it sets how slow the LCD clock can go.
+// We only get here about once a day, from wakes that are already talking to the RV3032, which is plenty since none of
+// these change fast for a box sitting in a closet. Sleeps a few seconds in LPM3 waiting on CLKOUT, see measure_vlo_hz().
 
-// These are displayed
-volatile unsigned int countdown_d,countdown_h,countdown_m,countdown_s;
+void tune_lcd() {
+    lcd_set_temperature( rv3032_read_temp_c() );
+    calibrate_lcd_clock();
+    update_lcd_bias();
+}
 
-// These are for safekeeping in case we reset.
-// Note that these are redundant, but it is faster to keep them in this separate format
+void stop_countdown_mode() {
+    disable_rv3032_clkout_interrupt();
+}
 
-countdown_time_t countdown_time;
 
+// On the last day the RV3032 alarm decides when we unlock rather than the tick count, so a missed or extra tick can only ever
+// make the display wrong, never the unlock. We keep the RTC midnight lined up with 0d 00:00:00 (see start_countdown_mode()), so
+// this is the same midnight alarm we use for dormant mode.
+// The RV3032 alarm can only match mins, hours, and date, so we can not just set it once at the start of a countdown that is years long.
 
-// Start calling the clkout vector above on each tick form the RTC, starting at next tick
-// note that you might want to call rc3032_zero() first to ensure a full second elapses before first tick.
+__interrupt void unlock_alarm_isr(void);    // Forward reference, defined below with countdown_unlock()
 
-void enable_rv3032_clkout_interrupt() {
-    // Now we enable the interrupt on the RTC CLKOUT pin. For now on we must remember to
-    // disable it again if we are going to end up in sleepforever mode.
+void arm_unlock_alarm() {
 
-    // Clear any pending interrupts from the RV3032 clkout pin and then enable interrupts for the next falling edge
-    // We we should not get a real one for 500ms so we have time to do our stuff
+    rv3032_arm_midnight_alarm( true );      // Keep the 1Hz ticks coming for the display
 
-    CBI( RV3032_CLKOUT_PIFG     , RV3032_CLKOUT_B    );
-    SBI( RV3032_CLKOUT_PIE      , RV3032_CLKOUT_B    );
+    SET_RV3032_INT_VECTOR( &unlock_alarm_isr );
+    enable_rv3032_int_interrupt();
 }
 
+void disarm_unlock_alarm() {
 
-void disable_rv3032_clkout_interrupt() {
-
-    CBI( RV3032_CLKOUT_PIE      , RV3032_CLKOUT_B    );
-    CBI( RV3032_CLKOUT_PIFG     , RV3032_CLKOUT_B    );
+    disable_rv3032_int_interrupt();
 
-}
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
+    rv3032_test_and_clear_alarm( rtc );     // Release ~INT in case it went off
+    rv3032_disarm_alarm( rtc );
+    rtc.end();
 
-void stop_countdown_mode() {
-    disable_rv3032_clkout_interrupt();
 }
 
 
 void start_setting_mode();          // Forward reference, defined below with the setting mode stuffs
+void enter_dormant_mode();          // Forward reference, defined below with the dormant mode stuffs
 
 
-enum class countdown_display_page_t {
-    HHMMSS,
-    DAYS,
-    BLANK
-};
+void resume_countdown_mode( unsigned days, unsigned hours, unsigned mins, unsigned secs);     // Forward reference, defined below with start_countdown_mode()
 
-volatile countdown_display_page_t countdown_display_page;
+// Once a day we check the count in the ISR registers against the RTC, which is the real authority since we lined its
+// midnight up with the day edges (see start_countdown_mode()). A missed or extra tick (say while another ISR was busy with the I2C)
+// would otherwise stay on the display for the rest of the countdown.
+// Costs one burst read a day. Returns false if the count was right, otherwise it fixes it up and returns true.
+// If we are fixed up to before midnight then `countdown_d` is left alone and the ISR will call countdown_next_day() again when it gets there.
+// With retune we also tune_lcd() first, since this is the one place a live countdown is already talking to the RV3032 every day.
+// That holds on to CLKOUT for a few seconds, so we stop the countdown while it runs (the display sits on 23:59:59 or 23:59) and
+// always take the fix up path after, which reads the RTC and picks the count back up from there.
 
-// Timer interrupt
-// Should fire once per second
+bool countdown_reconcile_with_rtc( unsigned minute_cadence , bool retune ) {
 
-#pragma vector=RV3032_CLKOUT_VECTOR
-__interrupt void clkout_isr(void) {
+    if ( retune ) {
+        stop_countdown_mode();
+        tune_lcd();
+    }
 
-    // CLear the pending interrupt.
-    // Do this first since there are a couple ways we can exit this ISR
-    RV3032_CLKOUT_PIV;          // Implemented as "MOV.W   &Port_1_2_P2IV,R15"
+    unsigned h,m,s;
+    rv3032_read_tod( h , m , s );
 
-    if (countdown_s==0) {
-        if (countdown_m==0) {
-            if (countdown_h==0) {
-                if (countdown_d==0) {
+    // The minute cadence ISR runs right on the RTC midnight, the 1Hz ISR runs on the tick after it.
 
-                    /// Time to unlock!!!!
+    if ( !retune && h == 0 && m == 0 && s == ( minute_cadence ? 0 : 1 ) ) {
+        return false;
+    }
 
-                    // We are done with this mode
-                    stop_countdown_mode();
+    bool early = ( h >= 12 );       // We got to the day edge before the RTC did
 
-                    // Show user we are opening
-                    lcd_show_open_message();
-                    lcd_on();                       // We might have been showing a blank page?
-                    lcd_show_LCDMEM_bank();         // I don't think there is anyway to get here and not be on LCDMEM, but just to be 100% safe.
+    hhmmss_complement( h , m , s );
 
-                    // Disable the clock interrupt since will do not want it anymore
-                    disable_rv3032_clkout_interrupt();
+    unsigned days = early ? countdown_d : countdown_d - 1;
 
-                    // The moment we have all been waiting for!!!!
-                    unlock();
+    // The per-minute checkpoint would have been off by the same amount
+    persist_countdown_mins( countdown_checkpoint_mins( days , h , m , s ) );
 
-                    // Now go back to setting mode so user can start a new countdown!
-                    start_setting_mode();
+    // This repaints everything and points the vector back at the BEGIN entry for the current cadence, so the registers get reloaded on the next tick.
+    resume_countdown_mode( days , h , m , s );
 
-                    // This return is an interrupt return so it will actually put us back to sleep, and the next wake will be from
-                    // the switch ISR because the user pressed a button or turned the trigger ring.
-                    return;
+    return true;
+}
 
-                }
-                countdown_h=24;
-                countdown_d--;
+// Called from COUNTDOWN_MODE_ISR (or COUNTDOWN_MINUTE_ISR) each time the hours roll under 00 and there is at least one day left.
+// Note that the ISR has already painted 23:59:59 (or 23:59) when we get here.
+// Returns the new day count. When that gets to 0 the ISR stops rotating pages and just shows HHMMSS.
 
-                // Update the days display page in LCMBMEM bank with the new day count
-                // Note this could be much more efficient by only updating the digits that changed etc, but who cares it only happens once every 86,400 seconds (24h*60m*60s).
-                lcd_show_days_lcdbmem(countdown_d);
+#pragma FUNC_EXT_CALLED
+unsigned countdown_next_day( unsigned minute_cadence ) {
 
-            }
-            countdown_m=60;
-            countdown_h--;
+    // Retune the LCD once a day, but only on days we will be awake for. Past COUNTDOWN_DORMANT_DAYS we are about to go
+    // dormant, and dormant_wake() retunes anyway.
+    const bool retune = ( countdown_d <= COUNTDOWN_DORMANT_DAYS + 1 );
 
-            *hours_lcdmemw = hours_lcd_words[countdown_h];          // Write the updated hours to the LCD in the LCDMEM bank
+    if ( countdown_reconcile_with_rtc( minute_cadence , retune ) ) {
 
+        // resume_countdown_mode() already took care of the days page and the last day stuff below
 
+        if ( countdown_d > COUNTDOWN_DORMANT_DAYS && countdown_h > 12 ) {
+            enter_dormant_mode();       // Never returns. Only if we got fixed up to after midnight, since the hours count down from 23 there.
         }
-        countdown_s=60;           // Yea I know this looks wrong, but we decremented at the top already.
-        countdown_m--;
-
-        *mins_lcdmemw = mins_lcd_words[countdown_m];            // Write the updated mins to the LCD in the LCDMEM bank
 
+        return countdown_d;
+    }
 
-        // TODO: Update the recovery data here.
+    countdown_d--;
 
-    }
+    // Update the days display page in LCMBMEM bank with the new day count. Every path into countdown mode paints the page
+    // with lcd_show_days_lcdbmem() first, so we can just step it and only touch the digits that changed.
+    lcd_show_days_lcdbmem_decrement();
 
-    countdown_s--;
+    // Note the checkpoint in FRAM is already up to date here since the ISR counts off each minute.
 
-    // Note that we do not bother to update the seconds digits on the LCD here becuase no one will see them
-    // if we are showing the day or blank pages. So instead we update them below only if we are on the HHMMSS page. Nice, right?
+    if (countdown_d > COUNTDOWN_DORMANT_DAYS ) {
+        // Still a long way to go, so stop ticking and sleep until the next midnight (or until someone presses MOVE).
+        enter_dormant_mode();       // Never returns
+    }
 
-    // Now update the display page
+    if (countdown_d==0) {
+        // From now on we continuously show the HHMMSS page for increased excitement.
+        // We might have been on the blank or days page, so get back to the HHMMSS page now.
+        lcd_blinking_mode_none();       // Stop the hardware from switching pages if it was (hardware rotation or minute cadence). The 1Hz ISR checks the days before it resyncs so it will not turn this back on.
+        lcd_show_LCDMEM_bank();
+        lcd_on();
 
-    // Order of pages is days->HHMMSS->blank
-    // This kind looks right because you read it "5 days... 4 hours and 22 minutes and 16 second... blank"
+        #ifndef COUNTDOWN_MINUTE_CADENCE
+            // With the minute cadence we are still using ~INT for the minutes here, and resume_countdown_mode() arms the alarm when the final hour starts.
+            arm_unlock_alarm();
+        #endif
+    }
 
-    // HHMMSS is first in the if chain so we can handle the special case when days == 0
-    // When days is zero, we continuously show the HHMMSS page for increased excitement.
-    if (countdown_display_page==countdown_display_page_t::HHMMSS || countdown_d==0 ) {
+    // The page schedule might change with the day count. The 1Hz ISR restarts it on the blank page when we return so the
+    // new count does not replace the old one right in front of you.
+    lcd_select_page_schedule( countdown_d , true );
 
-        *secs_lcdmemw = secs_lcd_words[countdown_s];                // Write the updated seconds to the LCD in the LCDMEM bank
+    return countdown_d;
+}
 
-        /*
-            // Wow, this compiler is not good. Below we can remove a whole instruction with 3 cycles that is completely unnecessary.
+__interrupt void button_isr(void);                                                          // Forward reference, defined below with the setting mode stuffs
 
-            asm("        MOV.B     &s+0,r15           ; [] |../tsl-calibre-msp.cpp:1390| ");
-            asm("        RLAM.W    #1,r15                ; [] |../tsl-calibre-msp.cpp:1390| ");
-            asm("        MOV.W     secs_lcd_words+0(r15),(LCDM0W_L+16) ; [] |../tsl-calibre-msp.cpp:1390|");
-        */
+// Called from COUNTDOWN_MINUTE_ISR when we get down to exactly 1:00:00 left. Switches to 1Hz ticks for the final hour.
+// The RTC seconds tick over with the minute, so the first 1Hz tick comes 1 second from now and we do not lose any time.
 
+#pragma FUNC_EXT_CALLED
+void countdown_final_hour() {
 
-        // The rest of the HHMMSS pattern is already in the primary LCD bank
-        lcd_show_LCDMEM_bank();         // Show the newly painted HHMMSS
+    disable_rv3032_int_interrupt();
+    rv3032_disable_minute_interrupt();
+    SET_SWITCH_VECTOR( &button_isr );       // Give the PORT1 vector back to the switches for when we get back to setting mode
 
-        countdown_display_page = countdown_display_page_t::BLANK;
+    resume_countdown_mode( 0 , 1 , 0 , 0 );
+}
 
-    } else if (countdown_display_page==countdown_display_page_t::BLANK) {
+// Called from unlock_alarm_isr() at 0d 00:00:00.
+// Also called from COUNTDOWN_MODE_ISR on the tick after 0d 00:00:00 as a backup, like for a countdown that started at 0 where
+// there is no midnight left for the alarm to match.
 
-        lcd_off();                  // Blank the display.
+#pragma FUNC_EXT_CALLED
+void countdown_unlock() {
 
-        countdown_display_page=countdown_display_page_t::DAYS;
+    /// Time to unlock!!!!
 
-        // Tricky part here:
-        // We have to switch the LCD display to the LCDBMEM bank that has the days painted in it here
-        // even though we will not be actually showing it until the next pass when we are on the days page.
-        // This is because if we do the switch below in the DAYS state, we get a visual flash on the LCD
-        // even if we do the switch while the LCD is off. The LCD controller should not do this, but it does. :/
-        // Moving it here with a delay between the bank change and the LCD turning on quenches the flash.
-        // This probably indicates that the ON/OFF only happens on frame boundaries but the bank switches are instant?
+    // We are done with this mode. This also disables the clkout interrupt since will do not want it anymore.
+    stop_countdown_mode();
+    disarm_unlock_alarm();
+    SET_SWITCH_VECTOR( &button_isr );       // Give the PORT1 vector back to the switches for setting mode
 
-        lcd_show_LCDBMEM_bank();            // The day page is already painted on the LCDBMEM bank so we only have to switch to that bank to show it.
+    persist_countdown_mins( 0 );
 
+    // Show user we are opening
+    lcd_show_open_message();        // This also clears the colon and decimal point that the countdown tables light up
+    lcd_on();                       // We might have been showing a blank page?
+    lcd_show_LCDMEM_bank();         // I don't think there is anyway to get here and not be on LCDMEM, but just to be 100% safe.
 
-    } else { // if (countdown_display_page==countdown_display_page_t::DAYS)
+    // The moment we have all been waiting for!!!!
+    unlock();
 
-        // Note that when we get here, the LCD is already pointing to the LCDBMEM bank with the days painted on it
-        // and the LCD is OFF so all we need to do here is turn on the LCD to let the days shine though. (See the preparations above in the BLANK state code)
+    // Now go back to setting mode so user can start a new countdown!
+    // When we return to the ISR it will do an interrupt return so it will actually put us back to sleep, and the next wake will be from
+    // the switch ISR because the user pressed a button or turned the trigger ring.
+    start_setting_mode();
 
-        lcd_on();                           // Show the days by turning the LCD back on. Must be after the bank switch or we might see a flicker.
+}
 
-        countdown_display_page=countdown_display_page_t::HHMMSS;
+// The RV3032 alarm pulled ~INT low at 0d 00:00:00. See arm_unlock_alarm().
+// Note that this is higher priority than the CLKOUT interrupt on PORT2, so we get in before the tick that would paint 00:00:00.
 
-    }
+__interrupt void unlock_alarm_isr(void) {
+    countdown_unlock();
 }
 
 enum class setting_units_t {
@@ -780,25 +1447,26 @@ volatile unsigned setting_digits[DIGITPLACE_COUNT-1];        // Current values (
 volatile unsigned setting_cursor_pos;        // Which digit position is the cursor currently on? 0=rightmost place.
 
 // Show the current setting values on the LCD
+// We draw both pages into frames and commit them so only the words that actually changed get written.
+
 void update_setting_display() {
 
+    lcd_frame_t frame = {};                 // LCDMEM
+    lcd_frame_t blink_frame = {};           // LCDBMEM. Only the place under the cursor is lit, so only it blinks.
 
     // Note that this does do leading zeros, which I think we want?
 
     // Show digits, starting at left going to right
     for( unsigned pos = 1; pos < DIGITPLACE_COUNT ; pos++ ) {
 
-        unsigned v = setting_digits[pos-1]; // -1 becuase LCD place 0 is used for units
+        const glyph_segment_t glyph = digit_glyphs[ setting_digits[pos-1] ]; // -1 becuase LCD place 0 is used for units
 
-        lcd_show_digit_f( LCDMEM , pos, v );
+        lcd_frame_set_glyph( frame , pos, glyph );
 
         // If the cursor is on this place...
         if (pos==setting_cursor_pos) {
             // ... make the segments blink
-            lcd_show_digit_f( LCDBMEM , pos, v);
-        } else {
-            // Otherwise clear all segments so no blink
-            lcd_show_f( LCDBMEM , pos , glyph_SPACE);
+            lcd_frame_set_glyph( blink_frame , pos, glyph );
         }
 
     }
@@ -828,15 +1496,16 @@ void update_setting_display() {
 
     }
 
-    lcd_show_f( LCDMEM , 0 , units_glyph);
+    lcd_frame_set_glyph( frame , 0 , units_glyph);
 
     // Is cursor currently on the units pos?
     if (setting_cursor_pos==0) {
-        lcd_show_f( LCDBMEM , 0 , units_glyph);
-    } else {
-        lcd_show_f( LCDBMEM , 0 , glyph_SPACE);
+        lcd_frame_set_glyph( blink_frame , 0 , units_glyph);
     }
 
+    lcd_commit_frame( LCDMEM  , frame );
+    lcd_commit_frame( LCDBMEM , blink_frame );
+
 }
 
 // When the switch bit here is 1, then button is up and we will interrupt high-to-low,
@@ -1121,64 +1790,40 @@ __interrupt void button_isr(void) {
 
             stop_setting_mode();
 
-            // combine the setting digits into a numeric value
-
-            unsigned v=0;
-
-            unsigned i= DIGITPLACE_COUNT-1;         // -1 because one of the digit places is used for the units indicator in setting mode, the rest are digits.
-            while (i>0) {                           // SLightly complicated so we can work from highest digit to lowest. C++ should have a reverse foreach syntax.
-                i--;
-                v*=10;
-                v+=setting_digits[i];
-            }
-
-            // Compute how long the countdown is based on the value and units the user gave us.
+            // Compute how long the countdown is based on the digits and units the user gave us.
+            // We do this digit by digit in days/hours/mins/secs so there are no long divides in here, since we are in an ISR.
 
-            unsigned d,h,m,s;
-
-            unsigned long secs;     // Luckily unsigned long can hold up to 136 years, so we can work with this size as our universal base time unit.
+            dhms_t unit;
 
             switch (setting_unit) {
 
             case setting_units_t::SECS:
-                secs = v;
+                unit = DHMS_SECOND;
                 break;
 
             case setting_units_t::HOURS:
-                secs = v * 60UL * 60UL;                 // 60 seconds per min * 60 mins per hour
+                unit = DHMS_HOUR;
                 break;
 
             case setting_units_t::DAYS:
-                secs = v * 60UL * 60UL * 24UL;         // .. * 24 hours in a day
+                unit = DHMS_DAY;
                 break;
 
             case setting_units_t::YEARS:
-                secs = v * 31556926UL; // https://frinklang.org/fsp/frink.fsp?fromVal=1+solaryear&toVal=seconds#calc
-
-                // "The mean tropical year is approximately 365 days, 5 hours, 48 minutes, 45 seconds."
-                // https://en.wikipedia.org/wiki/Tropical_year#:~:text=the%20mean%20tropical%20year%20is%20approximately%20365%20days%2C%205%20hours%2C%2048%20minutes%2C%2045%20seconds.
-                // Note that we are depending on the UI code to prevent years from ever being >100 or else our seconds variable here could overflow.
+                unit = DHMS_YEAR;
+                // Note that we are depending on the UI code to prevent years from ever being >100 or else days could overflow.
+                break;
 
             }
 
+            // -1 because one of the digit places is used for the units indicator in setting mode, the rest are digits.
+            // The result comes back normalized, so, say, 120 seconds shows up correctly as 2 min.
 
-            // Normalize the total seconds to days, hours, mins, and secs
-            // This ensures that, say, 120 seconds shows up correctly as 2 min.
-
-            d= (secs / (60UL * 60UL * 24UL));
-            secs = secs - ( d * 60UL * 60UL *24UL );
-
-            h= (secs / (60UL * 60UL) );
-            secs = secs - ( h * 60UL * 60UL );
-
-            m= secs / (60UL);
-            secs = secs - ( m* 60UL);
-
-            s=secs;
+            const dhms_t t = dhms_from_digits( setting_digits , DIGITPLACE_COUNT-1 , unit );
 
             // Start the countdown
 
-            start_countdown_mode(d, h, m, s);
+            start_countdown_mode( t.days , t.hours , t.mins , t.secs );
 
 
         }
@@ -1322,15 +1967,103 @@ void tsl_next_day() {
  */
 
 
+void resume_countdown_mode( unsigned days, unsigned hours, unsigned mins, unsigned secs);
+
 void start_countdown_mode( unsigned days, unsigned hours, unsigned mins, unsigned secs) {
 
-    // Restart the RTC starting... now. This means the first interrupt will happen in 1 second - plenty of time for us to do out init work here.
+    // Set the RTC so that its midnight lands exactly when the HHMMSS part of the countdown next passes 00:00:00.
+    // This lets the RTC alarm wake us on the day edges if we go dormant (see enter_dormant_mode()).
+    // Writing the seconds also restarts the prescaler so the first interrupt will happen in 1 second - plenty of time for us to do out init work here.
     // This also makes things *feel* right so that the second tick is aligned with whatever user action that got us here.
-    rv3032_zero();
+
+    unsigned tod_h = hours , tod_m = mins , tod_s = secs;
+    hhmmss_complement( tod_h , tod_m , tod_s );
+
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
+
+    rv3032_set_tod( rtc , tod_h , tod_m , tod_s );
+
+    // From here on the RTC time means something, so start watching for it getting lost (see warm_resume()).
+    rv3032_clear_LV_flags( rtc );
+
+    rtc.end();
+
+    // Checkpoint the time left as of the last whole minute boundary
+    persist_countdown_mins( countdown_checkpoint_mins( days , hours , mins , secs ) );
+
+    resume_countdown_mode( days , hours , mins , secs );
+}
+
+#ifdef COUNTDOWN_MINUTE_CADENCE
+
+// The once-a-minute version of resume_countdown_mode(). See COUNTDOWN_MINUTE_ISR.
+
+void resume_countdown_minute_mode( unsigned days, unsigned hours, unsigned mins, unsigned secs) {
+
+    // COUNTDOWN_MINUTE_ISR writes the next minute right on the minute edge, so if we are sitting exactly on an edge then show
+    // what it would have written there. Our caller makes sure there is more than an hour left so this can not underflow.
+
+    if ( secs == 0 ) {
+        if ( mins ) {
+            mins--;
+        } else {
+            mins = 59;
+            if ( hours ) {
+                hours--;
+            } else {
+                hours = 23;
+                days--;
+            }
+        }
+    }
+
+    countdown_d = days;
+    countdown_h = hours;
+    countdown_m = mins;
+    countdown_s = 0;                // Not used until the final hour, and countdown_final_hour() sets it then
+
+    lcd_blinking_mode_none();
+
+    lcd_show_countdown_hhmm( countdown_h , countdown_m );
+    lcd_show_day_label_lcdbmem();
+    lcd_show_days_lcdbmem( countdown_d );
+
+    if ( countdown_d > 0 ) {
+        // There is no ISR page handler in this mode so we always let the LCD hardware alternate between HH:MM and the days.
+        lcd_blinking_mode_page_rotation();
+    } else {
+        lcd_show_LCDMEM_bank();
+    }
+
+    // The first ~INT goes to COUNTDOWN_MINUTE_MODE_BEGIN which loads up the registers and then points the vector at COUNTDOWN_MINUTE_ISR.
+
+    rv3032_enable_minute_interrupt();
+    SET_RV3032_INT_VECTOR( &COUNTDOWN_MINUTE_MODE_BEGIN );
+    enable_rv3032_int_interrupt();
+
+}
+
+#endif
+
+// Get the countdown display and ISR going from the given time left. Assumes the RTC is already lined up (see start_countdown_mode()).
+
+void resume_countdown_mode( unsigned days, unsigned hours, unsigned mins, unsigned secs) {
+
+    #ifdef COUNTDOWN_MINUTE_CADENCE
+
+        // More than an hour left? Then we only need to wake once a minute until the final hour.
+        // Exactly one hour left goes straight to 1Hz ticks.
+
+        if ( days || hours > 1 || ( hours == 1 && ( mins || secs ) ) ) {
+            resume_countdown_minute_mode( days , hours , mins , secs );
+            return;
+        }
+
+    #endif
 
     // Switch to LCD mode where we can manually double buffer. We keep the days page on the second LCDBMEM page.
     // The blink none mode prevents the blinking hardware from automatically switching the pages on us,
-    // we will do it ourselves.
+    // we will do it ourselves (or turn on the hardware page rotation below).
     lcd_blinking_mode_none();
 
     // Init the values we use inside the ISR
@@ -1345,9 +2078,9 @@ void start_countdown_mode( unsigned days, unsigned hours, unsigned mins, unsigne
     // We need to do this because the ISR only updates digits that change, so this
     // paints all the digits so something will be there until they next change.
 
-    *secs_lcdmemw    = secs_lcd_words[countdown_s];
-    *mins_lcdmemw    = secs_lcd_words[countdown_m];
-    *hours_lcdmemw   = secs_lcd_words[countdown_h];
+    // This uses the same tables as the ISR so we also get the colon and decimal point.
+
+    lcd_show_countdown_hhmmss( countdown_h , countdown_m , countdown_s );
 
     // Now init that second page with the current day count and the label (which will stay there)
     // Note that the ISR will switch to this page when/if it wants to display it.
@@ -1355,30 +2088,31 @@ void start_countdown_mode( unsigned days, unsigned hours, unsigned mins, unsigne
     lcd_show_day_label_lcdbmem();
     lcd_show_days_lcdbmem( countdown_d );
 
+    // COUNTDOWN_MODE_BEGIN starts the page schedule where this tells it, using the same rules as below.
+    // Next will be HHMMSS, or the blank page if there are no hours, mins, or seconds (otherwise it looks weird if 5 days turns directly to 4 days).
+    lcd_select_page_schedule( countdown_d , !( countdown_h || countdown_m || countdown_s ) );
+
     if ( countdown_d >0) {
 
-        // If countdown is more than a day, then show the day count initially
-        lcd_show_LCDBMEM_bank();
+        #ifdef COUNTDOWN_HARDWARE_PAGE_ROTATION
 
-        if ( countdown_h==0 && countdown_m==0 && countdown_s==0) {
-            // Go next to the blank page otherwise it looks weird if 5 days turns directly to 4 days.
-            countdown_display_page = countdown_display_page_t::BLANK;
-        } else {
-            // If there are also some hours, mins, or seconds then show those. This can happen, say, if the setting was 49 hours (=2 days + 1 hour)
-            countdown_display_page = countdown_display_page_t::HHMMSS;
-        }
+            // Let the LCD hardware alternate between HHMMSS and the days from here on.
+            lcd_blinking_mode_page_rotation();
+
+        #else
+
+            // If countdown is more than a day, then show the day count initially
+            lcd_show_LCDBMEM_bank();
+
+        #endif
 
     } else {
 
         // If less than a day left then show HHMMSS now (and for the rest of the countdown)
         lcd_show_LCDMEM_bank();
-        countdown_display_page = countdown_display_page_t::HHMMSS;
 
     }
 
-    // Now compute the values for the backup counters....
-    // TODO: compute backup counters
-
     // Enable the interrupts so we wake up on each rising edge of the RV3032 clkout.
     // The RV3032 is always set to 1Hz so this will wake us once per second.
 
@@ -1387,9 +2121,223 @@ void start_countdown_mode( unsigned days, unsigned hours, unsigned mins, unsigne
 
     // Clear any pending interrupts from the RV3032 clkout pin and then enable interrupts for the next falling edge
     // This will start calling the ISR on the next tick.
+    // The first tick goes to COUNTDOWN_MODE_BEGIN which loads up the registers and then points the vector at COUNTDOWN_MODE_ISR for the rest of the countdown.
 
+    SET_CLKOUT_VECTOR( &COUNTDOWN_MODE_BEGIN );
     enable_rv3032_clkout_interrupt();
 
+    if ( countdown_d == 0 ) {
+        arm_unlock_alarm();
+    }
+
+}
+
+
+// Dormant mode
+// We get here from countdown_next_day() while there are more than COUNTDOWN_DORMANT_DAYS left. Everything is off except
+// the RV3032, which wakes us at its next midnight with the alarm on ~INT. A press of the MOVE button also wakes us to show a snapshot.
+// Note that waking from LPM4.5 is a reset, so neither pin interrupt ever actually runs an ISR - main() spots the
+// wakeup in SYSRSTIV and calls dormant_wake() to sort out what happened.
+
+#pragma FUNC_NEVER_RETURNS
+void enter_dormant_mode() {
+
+    disable_rv3032_clkout_interrupt();
+
+    // Completely off rather than just blanked since there is no clock for the LCD in LPM4.5 anyway.
+    lcd_shutdown();
+
+    // ...and no need for the LCD bias
+    CBI( TSP_ENABLE_POUT , TSP_ENABLE_B );
+    CBI( TSP_IN_POUT , TSP_IN_B );
+
+    rv3032_arm_midnight_alarm( false );
+
+    // Listen for the alarm pulling ~INT down (this also takes care of the minute cadence having been on)...
+    enable_rv3032_int_interrupt();
+
+    // ...and for a MOVE press. Note that the pull select is already UP from initGPIO().
+    CBI( SWITCH_MOVE_PDIR , SWITCH_MOVE_B );
+    SBI( SWITCH_MOVE_POUT , SWITCH_MOVE_B );
+    SBI( SWITCH_MOVE_PIES , SWITCH_MOVE_B );
+
+    // Changing the pin could have set the flag, and any pending interrupt would wake us right back up.
+    CBI( SWITCH_MOVE_PIFG , SWITCH_MOVE_B );
+    SBI( SWITCH_MOVE_PIE , SWITCH_MOVE_B );
+
+    sleep_until_pin_wakeup();
+}
+
+// Sleeps in LPM3 for 2^15 VLO clocks (~3.3 secs). The LCD keeps running since VLO stays on in LPM3.
+
+void snapshot_delay() {
+    sleep_vlo_interval( WDTIS__32K );
+}
+
+// Show the time left for a few seconds, then turn the LCD back off.
+// This is a still picture since nobody is going to watch it for more than a couple of ticks.
+
+void show_dormant_snapshot() {
+
+    unsigned days = recall_countdown_mins() / MINS_PER_DAY;        // As of the last RTC midnight
+
+    unsigned h,m,s;
+    rv3032_read_tod( h , m , s );
+
+    if ( ( h || m || s ) && days ) {
+        days--;                     // Part way through a day
+    }
+
+    hhmmss_complement( h , m , s );
+
+    initLCD();
+
+    lcd_show_countdown_hhmmss( h , m , s );
+    lcd_show_day_label_lcdbmem();
+    lcd_show_days_lcdbmem( days );
+
+    lcd_blinking_mode_page_rotation();      // Let the hardware alternate between HHMMSS and the days for us
+
+    snapshot_delay();
+
+    lcd_blinking_mode_none();
+    lcd_shutdown();
+}
+
+// Called from main() when we wake from dormant mode.
+// Returns if the countdown has gone live again, otherwise goes back to sleep.
+
+void dormant_wake() {
+
+    bool midnight = rv3032_test_and_clear_alarm();
+
+    if ( !midnight ) {
+
+        // Must have been the MOVE button
+        show_dormant_snapshot();
+
+        // Midnight could have come while we were showing the snapshot. We would miss it since enter_dormant_mode() clears the pin flags.
+        midnight = rv3032_test_and_clear_alarm();
+    }
+
+    if ( midnight ) {
+
+        unsigned long mins = recall_countdown_mins() - MINS_PER_DAY;
+        persist_countdown_mins( mins );
+
+        unsigned days = mins / MINS_PER_DAY;
+
+        if ( days <= COUNTDOWN_DORMANT_DAYS ) {
+
+            // Close enough now, so back to ticking for the rest of the countdown.
+            // The ~INT pin goes back to driving low the way initGPIO() left it.
+
+            rv3032_disarm_alarm();
+
+            // The LCD has been off since the last one of these, so we get a fresh measurement before we turn it on.
+            // This takes a few seconds, which is why it comes before we read the time.
+            tune_lcd();
+
+            unsigned h,m,s;
+            rv3032_read_tod( h , m , s );
+
+            if ( ( h || m || s ) && days ) {
+                days--;                     // We are a few secs past the midnight
+            }
+
+            hhmmss_complement( h , m , s );
+
+            initLCD();
+
+            resume_countdown_mode( days , h , m , s );
+
+            return;
+        }
+    }
+
+    enter_dormant_mode();
+}
+
+
+// The days part of the time left, from a checkpoint and whether the RTC is past its midnight (that is, its time of day is not 00:00:00).
+// The checkpoint can be anywhere from fresh (a live countdown takes a minute off every minute) to as old as the last RTC midnight
+// (dormant mode only updates it then), but either way rounding it up to a whole day gives the days left as of that midnight.
+
+constexpr unsigned countdown_days_from_checkpoint( unsigned long mins , bool past_midnight ) {
+    return (unsigned) ( ( mins + MINS_PER_DAY - 1 ) / MINS_PER_DAY ) - ( past_midnight ? 1 : 0 );
+}
+
+// 10 days left at the last RTC midnight, then a reset while dormant just before and just after RTC noon. Rounding to the nearest
+// day from the stale checkpoint used to give 10 after noon.
+static_assert( countdown_days_from_checkpoint( 10 * MINS_PER_DAY , true ) == 9 , "Dormant checkpoint should give 9 days left at any time of day" );
+
+// A live checkpoint with 3 days and 12:00:01 left (RTC 11:59:59) and with 3 days and 11:59:59 left (RTC 12:00:01)
+static_assert( countdown_days_from_checkpoint( countdown_checkpoint_mins( 3 , 12 , 0 , 1 ) , true ) == 3 , "Live checkpoint just before RTC noon should give 3 days left" );
+static_assert( countdown_days_from_checkpoint( countdown_checkpoint_mins( 3 , 11 , 59 , 59 ) , true ) == 3 , "Live checkpoint just after RTC noon should give 3 days left" );
+
+// Right on the RTC midnight the checkpoint is a whole number of days
+static_assert( countdown_days_from_checkpoint( countdown_checkpoint_mins( 3 , 0 , 0 , 0 ) , false ) == 3 , "Checkpoint right on RTC midnight should give 3 days left" );
+
+// Pick a countdown back up after a reset that was not a dormant wake (a brownout, a battery swap, the debugger...).
+// Since the RTC has been keeping time all along we can skip rv3032_init() and its wait for the RTC to come up, and we know exactly
+// where we are down to the second from one burst read.
+// Returns false if there is no countdown to resume or the RTC lost track of time.
+
+bool warm_resume() {
+
+    unsigned long mins = recall_countdown_mins();
+
+    if ( !mins ) {
+        return false;               // No countdown running
+    }
+
+    i2c_session_t rtc( RV_3032_I2C_ADDR );
+
+    if ( !rv3032_time_valid( rtc ) ) {
+        rtc.end();
+        return false;
+    }
+
+    // Make sure the RTC is still set up the way rv3032_init() left it. This also fills the shadow so the disarm below only
+    // writes what it needs to.
+    if ( rv3032_verify_config( rtc ) ) {
+        rv3032_apply_config( rtc );
+    }
+
+    // In case we reset while dormant. This also gets CLKOUT going again.
+    rv3032_disarm_alarm( rtc );
+    rtc.end();
+
+    tune_lcd();                     // Before we read the time since it takes a few seconds
+
+    unsigned h,m,s;
+    rv3032_read_tod( h , m , s );
+
+    // We might have been live or dormant, so the checkpoint could be up to a day old. See countdown_days_from_checkpoint().
+    const unsigned days = countdown_days_from_checkpoint( mins , h || m || s );
+
+    hhmmss_complement( h , m , s );     // The HHMMSS left is exact since the RTC midnight is lined up with the countdown
+
+    initLCD();
+
+    resume_countdown_mode( days , h , m , s );
+
+    return true;
+}
+
+// Pick a countdown back up from just the FRAM checkpoint after the RTC has lost time, like if the batteries were out
+// for a while. We lose however long we were down, but at least the capsule does not forget it is locked.
+// Assumes rv3032_init() has been called.
+
+void restart_countdown_from_checkpoint( unsigned long mins ) {
+
+    unsigned days = mins / MINS_PER_DAY;
+    mins -= days * MINS_PER_DAY;
+
+    unsigned hours = mins / MINS_PER_HOUR;
+    mins -= hours * MINS_PER_HOUR;
+
+    start_countdown_mode( days , hours , mins , 0 );
 }
 
 
@@ -1500,23 +2448,67 @@ int main( void )
     SYSCFG0 |= PFWP;                    // Program FRAM write protected (not writable)
 
 
+    // Find out why we are booting. Reading SYSRSTIV clears the highest pending reason, so keep going until we have seen them all.
+    bool dormant_wakeup = false;
+    unsigned rstiv;
+    while ( ( rstiv = SYSRSTIV ) != SYSRSTIV_NONE ) {
+        if ( rstiv == SYSRSTIV_LPM5WU ) {
+            dormant_wakeup = true;
+        }
+    }
+
     // Init GPIO first to be safe.
     initGPIO();
-    // Init LCD next so we can talk
-    initLCD();
 
-    // Power up display with a nice dash pattern
-    lcd_show_dashes();
+    // The switches get the PORT1 vector unless a countdown takes it over for the RV3032 ~INT (see resume_countdown_minute_mode())
+    SET_SWITCH_VECTOR( &button_isr );
+    SET_WDT_VECTOR( &wdt_isr );
 
-    //#warning stop here for now
-    //while (1);
+    // From here on all interrupts go though the RAM vector table so the asm ISRs can swap themselves in and out.
+    // The only interrupts we ever enable are the switches or the RV3032 ~INT on PORT1, the RV3032 CLKOUT on PORT2, and the WDT
+    // for sleep_vlo_interval(). This has to come before anything below sleeps, since tune_lcd() waits on CLKOUT and PORT2 has no
+    // FRAM vector.
+    ACTIVATE_RAM_ISRS();
 
-    // Initialize the RV3032 with proper clkout & backup settings.
-    rv3032_init();
+    if ( dormant_wakeup ) {
 
-    //regulatorTest();
+        // The RV3032 is already up and running and the LCD is off, so skip all the init below.
+        // If we come back from here then the countdown is live again.
+        dormant_wake();
+
+    } else if ( warm_resume() ) {
+
+        // Countdown picked up right where it left off
+
+    } else {
+
+        // Init LCD next so we can talk
+        initLCD();
+
+        // Power up display with a nice dash pattern
+        lcd_show_dashes();
+
+        //#warning stop here for now
+        //while (1);
+
+        // Initialize the RV3032 with proper clkout & backup settings.
+        rv3032_init();
+
+        // Now that CLKOUT is running we can tune the LCD for this unit. The dashes stay up while we do it.
+        tune_lcd();
+
+        //regulatorTest();
+
+        unsigned long mins = recall_countdown_mins();
+
+        if ( mins ) {
+            // We were locked when the RTC lost time
+            restart_countdown_from_checkpoint( mins );
+        } else {
+            start_setting_mode();
+        }
+    }
 
-    start_setting_mode();
     sleep_with_interrupts();                    // Wait for interrupts to take over.
 
     // should never never get here.
@@ -2,8 +2,8 @@
 
         	.cdecls C,LIST,"msp430.h"  				; Include device header file
             .cdecls C,LIST,"lcd_display_exp.h"  	; Links to the info we need to update the LCD
+            .cdecls C,LIST,"persistent_data.h"  	; Offsets into the FRAM countdown checkpoint
 
-            .global RTL_MODE_BEGIN
             .global TSL_MODE_BEGIN
             .global TSL_MODE_REFRESH
 
@@ -192,80 +192,449 @@ TSL_MODE_REFRESH
 
 			JMP		TSL_MODE_ISR
 
-;---- RTL ISR RAMFUNC
-; 48us
-; 26us startup after CLKOUT from FRAM
-; 1.33uA
+;---- COUNTDOWN ISR RAMFUNC
+;
+; Counts down from the time that start_countdown_mode() painted onto the LCD, one tick per RV3032 CLKOUT rising edge.
+; Same trick as TSL mode: all of the state lives in call-saved registers so a normal tick is just one table-to-LCDMEM move,
+; a compare, and a jump to the handler for the current display page.
+;
+; We walk up the countdown tables (see lcd_display_exp.h) with post-increment. They count down and are rotated so that the
+; rollover entry ("59" or "23") is last, so we only need to check for a rollover when a pointer hits the end of its table.
+; This way we only need to keep the end of each table in a register since we get back to the top by subtracting the size.
+;
+; The secs are the exception. We watch for the "00" entry, since that is the tick where one less whole minute is left and we
+; take it off the FRAM checkpoint. That tick points the vector at CD_MIN_ROLL for the next one, which shows the "59", steps the mins,
+; and points the vector back here. So the checkpoint is always the minutes left rounded up (see persistent_data.h) and the
+; normal tick is still one move, one compare, and one jump.
+;
+;	R4  = The "59" entry at the end of the secs table
+;	R5  = Pointer to the next entry to show in the secs table
+;	R6  = 1 word past the end of the mins table
+;	R7  = Pointer to the next entry to show in the mins table
+;	R8  = 1 word past the end of the hours table
+;	R9  = Pointer to the next entry to show in the hours table
+;	R10 = Pointer to the entry for this tick in the page schedule (see lcd_select_page_schedule() and LCD_PAGE_xxx in lcd_display_exp.h)
+;
+; Each schedule entry is a byte offset into the jump table at CD_PAGE_DISPATCH, so the dispatch is an ADD to the PC and a JMP.
+; Counted from the CPUX instruction cycle tables (including the 6 cycle interrupt entry and the 5 cycle RETI), not yet scoped:
+;	HOLD tick     29 cycles
+;	LAST_DAY tick 30 cycles
+;	HHMMSS, BLANK, or DAYS tick (a page change) 39 cycles
+;	plus about 10 cycles for the LCD_PAGE_WRAP at the end of each pass through the schedule
+;	plus about 37 cycles on the :00 tick (CD_CHECKPOINT and the vector write) and about 20 on the roll tick after it, so about 10
+;	more a minute than when the checkpoint rode along with the roll
+; ...versus roughly 70 cycles for the old C clkout_isr() (push/pop of the scratch regs, 4 volatile loads, the nested if chain
+; and the page switch all happen on every tick there). The old fixed 3 page rotation was 32/36/32 cycles, so the normal
+; schedule costs about 27 more cycles per 3 second pass. A hold tick is cheaper than any of the old ticks though, so longer dwells
+; bring the average back down (the long schedule is about 37 cycles a tick).
+;
+; If COUNTDOWN_HARDWARE_PAGE_ROTATION is defined (see lcd_display_exp.h) then the LCD blink hardware alternates the HHMMSS and
+; days pages, R10 is not used, and every tick is 23 cycles.
+
+			.global COUNTDOWN_MODE_BEGIN
+
+			;Assumes the symbol `ram_vector_PORT2` is the address of the ISR vector for the RV3032 CLKOUT pin.
+			.ref		ram_vector_PORT2
+
+			.ref		countdown_d				; - days left. The C side owns this one, we only check it for zero.
+
+			.ref		secs_countdown_lcd_words	; - the countdown tables. Note these are const pointers to the tables.
+			.ref		mins_countdown_lcd_words
+			.ref		hours_countdown_lcd_words
+
+			.if !$DEFINED(COUNTDOWN_HARDWARE_PAGE_ROTATION)
+			.ref		lcd_page_schedule		; - the page schedule to play, read at the end of each pass
+			.ref		lcd_page_schedule_next	; - where to start in it. Set by lcd_select_page_schedule().
+			.endif
+
+			;countdown_next_day is called each time the hours roll under 00. It checks us against the RTC, decrements the days, repaints the days page,
+			;and returns the new day count in R12.
+			; The argument in R12 is 1 if the call is from the minute cadence ISR (so it knows when we should have called)
+			; Note this is the mangled C++ name for `unsigned countdown_next_day(unsigned)`
+			.ref		_Z18countdown_next_dayj
+
+			;countdown_unlock is called when we tick past 0d 00:00:00. It opens the lock and goes back to setting mode.
+			; Note this is the mangled C++ name for `void countdown_unlock()`
+			.ref		_Z16countdown_unlockv
+
+			;The countdown checkpoint in infoA FRAM (see persistent_data.h)
+			.ref		persistent_data
+
+			;countdown_checkpoint_borrow is called when the low word of the checkpoint would borrow from the high word.
+			; Note this is the mangled C++ name for `void countdown_checkpoint_borrow()`
+			.ref		_Z27countdown_checkpoint_borrowv
+
+; Call a C function. In the large code model the C side returns with RETA so we must use CALLA to push a 20 bit return address.
+CALL_C		.macro		func
+			.if $DEFINED(__LARGE_CODE_MODEL__)
+			CALLA		#func
+			.else
+			CALL		#func
+			.endif
+			.endm
+
+; Take one minute off the FRAM checkpoint. Called at each minute boundary by both countdown ISRs.
+; Normally this is a single decrement of the low word, which the MSP430 writes to FRAM atomically, so a reset can never catch it
+; half done. Only when the low word is 0 do we go to C for the two copy transaction (once every 2^16 minutes ~= every 45 days).
+; Counted about 30 cycles including the CALL and RET (two of them FRAM writes), which is small next to the 60 ticks that came before it.
+; Not measured on a scope or with EnergyTrace yet.
+
+CD_CHECKPOINT
+
+			TST.W		&(persistent_data+PERSISTENT_COUNTDOWN_MINS_L_OFFSET)
+			JEQ			CD_CHECKPOINT_BORROW
+
+			MOV.W		#PFWP,&SYSCFG0				; Unprotect data FRAM. Must match unlock_persistant_data().
+			DEC.W		&(persistent_data+PERSISTENT_COUNTDOWN_MINS_L_OFFSET)
+			MOV.W		#(PFWP|DFWP),&SYSCFG0		; and protect it again. Must match lock_persistant_data().
+			RET
+
+CD_CHECKPOINT_BORROW
+
+			PUSHM.A		#5,R15
+			CALL_C		_Z27countdown_checkpoint_borrowv
+			POPM.A		#5,R15
+			RET
+
+
+; Finish up a tick. With hardware page rotation we are done, otherwise go do the page schedule entry for this tick.
+CD_TICK_DONE	.macro
+			.if $DEFINED(COUNTDOWN_HARDWARE_PAGE_ROTATION)
+			MOV.B		#0,&PAIFG_H+0				; Clear the interrupt flag that got us here (only CLKOUT interrupts on port 2)
+			RETI
+			.else
+			JMP			CD_PAGE_DISPATCH
+			.endif
+			.endm
+
+COUNTDOWN_MODE_BEGIN:
+
+	;Same idea as TSL_MODE_BEGIN - we do our init on the first tick so that no C code can run between our init and the
+	;first real pass and clobber our carefully loaded registers.
+
+	;Note the XXX_countdown_lcd_words symbols are const pointers to the tables (see lcd_display_exp.h) so we need to dereference them
+	;with & to get the table address.
+
+	;The entry after the one showing N is at (size-1-N) in these tables (see the layout above), so the pointer is base+2*(size-1)-2*N.
+
+			MOV.W		&secs_countdown_lcd_words,R4
+			ADD.W		#(2*(COUNTDOWN_SECS_TABLE_SIZE-1)),R4	; R4=The "59" entry at the end of the secs table
+			MOV.W		R4,R5
+			SUB.W		&countdown_s,R5
+			SUB.W		&countdown_s,R5							; R5=Pointer to the next secs entry
 
-;---- RTL SQUIGLLE ISR FRAM
-; 51us
-; 28us startup after CLKOUT from FRAM
-; 1.35uA
+			MOV.W		&mins_countdown_lcd_words,R7
+			MOV.W		R7,R6
+			ADD.W		#(2*COUNTDOWN_MINS_TABLE_SIZE),R6		; R6=1 word past the end of the mins table
+			ADD.W		#(2*(COUNTDOWN_MINS_TABLE_SIZE-1)),R7
+			SUB.W		&countdown_m,R7
+			SUB.W		&countdown_m,R7							; R7=Pointer to the next mins entry
 
-;Begin the RTL mode ISR
-;Set the ISR vector to point here to start this mode.
+			MOV.W		&hours_countdown_lcd_words,R9
+			MOV.W		R9,R8
+			ADD.W		#(2*COUNTDOWN_HOURS_TABLE_SIZE),R8		; R8=1 word past the end of the hours table
+			ADD.W		#(2*(COUNTDOWN_HOURS_TABLE_SIZE-1)),R9
+			SUB.W		&countdown_h,R9
+			SUB.W		&countdown_h,R9							; R9=Pointer to the next hours entry
 
-RTL_MODE_BEGIN:
-	;This entry point sets up all the registers and changes the PORT_1 vector to point to the optimized ISR, which will get called directly on subsequent interrupts
-	;First we update the vector to point to the recurring ISR vector
-	mov.w	#RTL_MODE_ISR, &ram_vector_PORT1
+			.if !$DEFINED(COUNTDOWN_HARDWARE_PAGE_ROTATION)
 
-	;For MSP430 and MSP430X, the ABI designates R4-R10 as callee-saved registers. That is, a called function is
-	;expected to preserve them so they have the same value on return from a function as they had at the point of the
-	;call.
+			; resume_countdown_mode() picked the schedule and where to start in it to match what it put up on the LCD.
+
+			MOV.W		&lcd_page_schedule_next,R10
+
+			.endif
+
+			; move the vector to point to our actual updater now that all the registers are set
+			MOV.W		#COUNTDOWN_MODE_ISR,&ram_vector_PORT2
+
+			; Starting on a whole minute? Then C already painted the "00" and checkpointed it, so this tick is the roll under to "59".
+
+			CMP.W		R5,R4
+			JEQ			CD_MIN_ROLL
+
+COUNTDOWN_MODE_ISR
+
+ 	  		;OR.B      	#128,&PAOUT_L+0  			; Set DEBUGA for profiling purposes.
+
+			MOV.W		@R5+,&(LCDM0W_L+SECS_LCDMEM_OFFSET)		; Write the secs digits and advance to the next entry
+
+			; Note we always update the secs even if they will not be seen on this page. It is cheaper than checking, and this way
+			; they are already correct when we get back to the HHMMSS page.
+
+			CMP.W		R5,R4						; Did we just show "00"?
+			JEQ			CD_MIN_DUE
+
+			.if $DEFINED(COUNTDOWN_HARDWARE_PAGE_ROTATION)
+
+			CD_TICK_DONE
+
+			.else
+
+			; The other paths through here jump back to this with CD_TICK_DONE, but this one is nearly every tick so it falls through.
+
+CD_PAGE_DISPATCH
+
+			ADD.W		@R10+,PC					; Jump into the table below by this tick's schedule entry, and advance to the next entry
+			JMP			CD_PAGE_HOLD				; LCD_PAGE_HOLD
+			JMP			CD_PAGE_HHMMSS				; LCD_PAGE_HHMMSS
+			JMP			CD_PAGE_BLANK				; LCD_PAGE_BLANK
+			JMP			CD_PAGE_DAYS				; LCD_PAGE_DAYS
+			JMP			CD_PAGE_LAST_DAY			; LCD_PAGE_LAST_DAY
+			JMP			CD_PAGE_WRAP				; LCD_PAGE_WRAP
+
+			.endif
+
+
+CD_MIN_DUE
+
+			CALL		#CD_CHECKPOINT				; One more minute gone, right on the minute boundary
+			MOV.W		#CD_MIN_ROLL,&ram_vector_PORT2		; The next tick rolls the secs under
+			CD_TICK_DONE
+
+
+CD_MIN_ROLL
+
+			; Back to normal ticks first, since countdown_next_day() below might point the vector somewhere else.
+
+			MOV.W		#COUNTDOWN_MODE_ISR,&ram_vector_PORT2
+
+			MOV.W		@R5+,&(LCDM0W_L+SECS_LCDMEM_OFFSET)		; Write the "59"
+			SUB.W		#(2*COUNTDOWN_SECS_TABLE_SIZE),R5		; Back to the top of the secs table
+
+ 	  		MOV.W		@R7+,&(LCDM0W_L+MINS_LCDMEM_OFFSET)		; Write the mins digits and advance
+
+			.if $DEFINED(COUNTDOWN_HARDWARE_PAGE_ROTATION)
+
+			; Resync the blink divider so the HHMMSS page starts now. The VLO that clocks it is not very accurate, so without this
+			; the pages would slowly slide around relative to the ticks. Skip it on the last day since we have stopped rotating then.
+
+			TST.W		&countdown_d
+			JEQ			CD_RESYNC_DONE
+			MOV.W		#(COUNTDOWN_PAGE_ROTATION_BLKPRE|LCDBLKMOD_0),&LCDBLKCTL		; "The divider generating the blinking frequency fBLINK is reset when LCDBLKMODx = 00."
+			MOV.W		#(COUNTDOWN_PAGE_ROTATION_BLKPRE|LCDBLKMOD_3),&LCDBLKCTL		; Back to switching between LCDMx and LCDBMx, starting on LCDMx
+CD_RESYNC_DONE
+
+			.endif
+
+			CMP.W		R7,R6						; Did we just show "59"?
+			JEQ			CD_NEXT_HOUR
+
+			CD_TICK_DONE
+
+
+CD_NEXT_HOUR
+
+			SUB.W		#(2*COUNTDOWN_MINS_TABLE_SIZE),R7		; Back to the top of the mins table
+
+ 	  		MOV.W		@R9+,&(LCDM0W_L+HOURS_LCDMEM_OFFSET)		; Write the hours digits and advance
+
+			CMP.W		R9,R8						; Did we just show "23"?
+			JEQ			CD_NEXT_DAY
+
+			CD_TICK_DONE
+
+
+CD_NEXT_DAY
+
+			SUB.W		#(2*COUNTDOWN_HOURS_TABLE_SIZE),R9		; Back to the top of the hours table
+
+			TST.W		&countdown_d				; Was that the last day?
+			JEQ			CD_UNLOCK
+
+			; Call into C for the once-a-day stuff. R4-R10 are call-saved so our state survives, but we are in an ISR
+			; so we also have to save the scratch regs that C is allowed to clobber.
+
+			PUSHM.A		#5,R15						; Save R11-R15
+			CLR.W		R12							; Called from the 1Hz ISR
+			CALL_C		_Z18countdown_next_dayj		; Returns new day count in R12
+			POPM.A		#5,R15
+
+			.if !$DEFINED(COUNTDOWN_HARDWARE_PAGE_ROTATION)		; With hardware page rotation countdown_next_day() already stopped the rotation on the last day
+
+			; countdown_next_day() picked the schedule for the new day count. We restart it on the blank page so the new count
+			; does not replace the old one right in front of you. On the last day it is HHMMSS from here on, and
+			; countdown_next_day() already switched us to that page.
+
+			MOV.W		&lcd_page_schedule_next,R10
+
+			.endif
+
+			CD_TICK_DONE
+
+
+CD_UNLOCK
+
+			; Time to unlock!!!! The C side disables this interrupt and then goes back to setting mode, so we never come back here.
+			; Note that we just wrote 23:59:59 into LCDMEM, but the C side paints over it long before the glass could respond.
+
+			PUSHM.A		#5,R15
+			CALL_C		_Z16countdown_unlockv
+			POPM.A		#5,R15
+
+			RETI
+
+
+			.if !$DEFINED(COUNTDOWN_HARDWARE_PAGE_ROTATION)
+
+; The page schedule handlers. R10 already points at the entry for the next tick. Each page handler sets both the bank and
+; LCDSON so the schedule can put the pages in any order. The bank switch happens on the BLANK tick instead of the DAYS tick
+; when it can, since that quenches a visible flash (see the comments on the page switching in the old C ISR).
+
+CD_PAGE_WRAP
+
+			MOV.W		&lcd_page_schedule,R10		; Back to the top, picking up any new schedule from countdown_next_day()
+			JMP			CD_PAGE_DISPATCH			; and do the first entry for this tick
+
+CD_PAGE_HHMMSS
+
+			BIC.W		#LCDDISP,&LCDMEMCTL			; Show the LCDMEM bank that has the HHMMSS painted on it
+			BIS.W		#LCDSON,&LCDCTL0			; We might be coming from the blank page
+			MOV.B		#0,&PAIFG_H+0				; Clear the interrupt flag that got us here (only CLKOUT interrupts on port 2)
+			RETI
+
+CD_PAGE_BLANK
+
+			BIC.W		#LCDSON,&LCDCTL0			; Blank the display
+			BIS.W		#LCDDISP,&LCDMEMCTL			; Switch to the LCDBMEM bank with the days painted on it while we are blank
+			MOV.B		#0,&PAIFG_H+0
+			RETI
+
+CD_PAGE_LAST_DAY
+
+			DECD.W		R10							; Stay on this entry
+			MOV.B		#0,&PAIFG_H+0
+			RETI
+
+CD_PAGE_DAYS
+
+			BIS.W		#LCDDISP,&LCDMEMCTL			; Usually already there from the blank page
+			BIS.W		#LCDSON,&LCDCTL0			; Let the days shine through
+			; Fall through to share the ending motif
+
+CD_PAGE_HOLD
+
+			MOV.B		#0,&PAIFG_H+0
+
+ 	  		;AND.B     #127,&PAOUT_L+0       ; Clear DEBUGA for profiling purposes.
+
+			RETI
+
+			.endif
+
+
+;---- COUNTDOWN MINUTE ISR RAMFUNC
+;
+; Same idea as COUNTDOWN_MODE_ISR, but driven once a minute by the RV3032 periodic time update on ~INT while there is more than
+; an hour left (see COUNTDOWN_MINUTE_CADENCE in lcd_display_exp.h). Only the mins and hours digits are showing and the LCD blink
+; hardware alternates them with the days page, so there are no page handlers.
+;
+; The RTC midnight is lined up with the countdown day edges (see start_countdown_mode()) so the update lands exactly when there
+; is a whole number of minutes left. We write the next mins entry right then, which is one second ahead of where the 1Hz ISR would
+; change it (it changes the mins when the secs roll under to 59). Both take the minute off the checkpoint right on the boundary.
+;
+;	R6  = 1 word past the end of the mins table
+;	R7  = Pointer to the next entry to show in the mins table
+;	R8  = 1 word past the end of the hours table
+;	R9  = Pointer to the next entry to show in the hours table
+;	R10 = Scratch
+;
+; Counted the same way as above, a normal minute is 24 cycles plus about 30 for CD_CHECKPOINT. Versus 60 ticks of at least 23 cycles each with the 1Hz ISR.
+
+			.if $DEFINED(COUNTDOWN_MINUTE_CADENCE)
+
+			.global COUNTDOWN_MINUTE_MODE_BEGIN
+
+			;countdown_final_hour is called when the hours roll under to 00 on the last day. It switches us over to the 1Hz ISR.
+			; Note this is the mangled C++ name for `void countdown_final_hour()`
+			.ref		_Z20countdown_final_hourv
+
+COUNTDOWN_MINUTE_MODE_BEGIN:
+
+			; Same as COUNTDOWN_MODE_BEGIN, minus the secs
+
+			MOV.W		&mins_countdown_lcd_words,R7
+			MOV.W		R7,R6
+			ADD.W		#(2*COUNTDOWN_MINS_TABLE_SIZE),R6		; R6=1 word past the end of the mins table
+			ADD.W		#(2*(COUNTDOWN_MINS_TABLE_SIZE-1)),R7
+			SUB.W		&countdown_m,R7
+			SUB.W		&countdown_m,R7							; R7=Pointer to the next mins entry
+
+			MOV.W		&hours_countdown_lcd_words,R9
+			MOV.W		R9,R8
+			ADD.W		#(2*COUNTDOWN_HOURS_TABLE_SIZE),R8		; R8=1 word past the end of the hours table
+			ADD.W		#(2*(COUNTDOWN_HOURS_TABLE_SIZE-1)),R9
+			SUB.W		&countdown_h,R9
+			SUB.W		&countdown_h,R9							; R9=Pointer to the next hours entry
+
+			; move the vector to point to our actual updater now that all the registers are set
+			MOV.W		#COUNTDOWN_MINUTE_ISR,&ram_vector_PORT1
+
+COUNTDOWN_MINUTE_ISR
+
+			BIC.B		#BIT4,&PAIFG_L				; Clear the ~INT flag that got us here (P1.4, checked against RV3032_INT_B on the C side)
+
+ 	  		MOV.W		@R7+,&(LCDM0W_L+MINS_LCDMEM_OFFSET)		; Write the mins digits and advance
+
+			CALL		#CD_CHECKPOINT				; One more minute gone
+
+			CMP.W		R7,R6						; Did we just show "59"?
+			JEQ			CDM_NEXT_HOUR
+
+			RETI
+
+
+CDM_NEXT_HOUR
+
+			SUB.W		#(2*COUNTDOWN_MINS_TABLE_SIZE),R7		; Back to the top of the mins table
+
+ 	  		MOV.W		@R9+,&(LCDM0W_L+HOURS_LCDMEM_OFFSET)		; Write the hours digits and advance
+
+			CMP.W		R9,R8						; Did we just show "23"?
+			JEQ			CDM_NEXT_DAY
+
+			TST.W		&countdown_d				; Only the last day can have a final hour
+			JNE			CDM_DONE
 
-	mov.w	#(128-1),R13 								; We will use this for a 1 cycle, no branch way to normalize our pointer which by luck is into an 8*(8*2) table
-	mov.w	R12,R14										; Keep a copy of the base address to OR in later
+			MOV.W		R9,R10
+			INCD.W		R10
+			CMP.W		R10,R8						; Did we just show "00"? It is the second to last entry.
+			JNE			CDM_DONE
 
+			; Down to 1:00:00 left, so time to switch to 1Hz ticks for the final hour. The C side takes over the ~INT vector again,
+			; so we never come back here.
 
-	;; Disable the FRAM controller
-	; With controller on uses 1.36uA
-	; With controller off uses 1.37uA
-	; Why?
-	; MOV.W	#FRCTLPW,&FRCTL0			; Write password to FRAM controller
-	; BIC.W	#FRPWR,&GCCTL0				; Clear the bit that turns on the controller on wake
+			PUSHM.A		#5,R15
+			CALL_C		_Z20countdown_final_hourv
+			POPM.A		#5,R15
 
-	; We are now ready, so drop into the real ISR. The real ISR will be called directly for now on since we updated the vector to point here.
+CDM_DONE
 
-; This is the entry point for the ISR
-; We leave this mode when the trigger is pulled by the trigger ISR
-RTL_MODE_ISR:
+			RETI
 
- 	; OR.B      #128,&PAOUT_L+0  ;			// DebugA ON - For profiling
 
-	; Copy the data for this frame into the LCDMEM registers.
-	; note only need to do this for the LPINs that are actually connected,
-	; which are the only ones we put into the table.
-	; note we can do this 4 nibbles at a time for free using .W instructions.
+CDM_NEXT_DAY
 
-      MOV.W @R12+,(LCDM0W_L+0)		; L0,L1,L2,L3 - 4 cycles
-      MOV.W @R12+,(LCDM0W_L+2)		; L4,L5,L6,L7
-	;					   +4		; L8,L9,L10,L11  (These are the COM pins, do not want to mess with them)
-      MOV.W @R12+,(LCDM0W_L+6)		; L12,L13,L14,L15
-      MOV.W @R12+,(LCDM0W_L+8)		; L16,L17,L18,L19
-      MOV.W @R12+,(LCDM0W_L+10)		; L20,L21,L22,L23
-      MOV.W @R12+,(LCDM0W_L+12)		; L24,L25,L26,L27
-      MOV.W @R12+,(LCDM0W_L+14)		; L28,L29,L30,L31
-      MOV.W @R12+,(LCDM0W_L+16)		; L32,L33,L34,L35
+			SUB.W		#(2*COUNTDOWN_HOURS_TABLE_SIZE),R9		; Back to the top of the hours table
 
-      AND.W R13,R12					; Look ma, no compare/branch/load! 1 cycle each AND and OR.
-      OR.W  R14,R12					; OR back in the base address (remember it is 128 byte aligned)
+			; Note countdown_d can not be 0 here since we would have gone to the 1Hz ISR at the start of the final hour.
+			; countdown_next_day() also takes care of stopping the page rotation when it gets to the last day.
 
+			PUSHM.A		#5,R15
+			MOV.W		#1,R12						; Called from the minute cadence ISR
+			CALL_C		_Z18countdown_next_dayj
+			POPM.A		#5,R15
 
-      BIC.B     #2,&PAIFG_L+0 ;  	; Clear interrupt flag
-      								; Note that we can not use the constant-MOV 0x00 trick that worked above becuase
-      								; in RTL mode the person could pull the trigger, which would set the flag for that pin and if
-      								; we then hd bad timing and cleared that bit here then the pull would be lost forever.
+			RETI
 
- 	  ; AND.B     #127,&PAOUT_L+0       ; DEBUGA OFF - For profiling
+			.endif
 
-      RETI
 
 ;------------------------------------------------------------------------------
 ;           Interrupt Vectors
 ;------------------------------------------------------------------------------
 
             ;.sect   PORT1_VECTOR              ; Vector
-            ;.short  RTL_MODE_BEGIN              ;
+            ;.short  TSL_MODE_BEGIN        ;
             .end
 
@@ -14,10 +14,6 @@
 
 extern "C" {
 
-    // Entry set vector to this to enter ready-to-launch mode on next interrupt
-    // Assumes the symbol `ready_to_launch_lcd_frames` points to a table of LCD frames for the squiggle animation
-    extern unsigned RTL_MODE_BEGIN; /* declare external asm function as an unsigned so we can easily stick it into the vector. */
-
     // Entry vector for time-since-launch mode
     // Assumes these symbols:
     // .ref    secs_lcd_words          ; - table of prerendered values to write to the seconds word in LCDMEM (one entry for each second 0-59)
@@ -29,6 +25,24 @@ extern "C" {
     // Will then switch the vector back to the normal TSL mode vector for the next tick.
     extern unsigned TSL_MODE_REFRESH;
 
+
+    // Entry vector for countdown mode. Set the CLKOUT RAM vector to this after start_countdown_mode() has painted the starting time.
+    // Assumes these symbols:
+    // .ref    countdown_d,countdown_h,countdown_m,countdown_s    ; - starting time (only read on the first tick, days are then owned by the C side)
+    // .ref    lcd_page_schedule,lcd_page_schedule_next           ; - the page schedule (see lcd_select_page_schedule())
+    // Calls back to C:
+    // unsigned countdown_next_day(unsigned minute_cadence)    ; - each time the hours roll under, returns the new day count
+    // void countdown_unlock()          ; - when the count ticks past zero
+    extern unsigned COUNTDOWN_MODE_BEGIN;
+
+    // Entry vector for the once-a-minute countdown (see COUNTDOWN_MINUTE_CADENCE). Set the RV3032 ~INT RAM vector to this.
+    // Assumes these symbols:
+    // .ref    countdown_h,countdown_m    ; - starting time (only read on the first minute)
+    // Calls back to C:
+    // unsigned countdown_next_day(unsigned minute_cadence)    ; - each time the hours roll under
+    // void countdown_final_hour()      ; - when we get down to 1:00:00 left, to hand off to COUNTDOWN_MODE_BEGIN
+    extern unsigned COUNTDOWN_MINUTE_MODE_BEGIN;
+
 }
 
 #endif /* TSL_ASM_H_ */